@@ -43,20 +43,98 @@ std::pair<int64_t, int64_t> solve(const std::vector<std::string> &lines) {
   return {dial.zero_end_count, dial.zero_cross_count};
 }
 
+struct Rotation {
+  char direction;
+  int distance;
+};
+
+// Parser thread streams rotations through an SPSC FIFO while this thread
+// turns the dial, so parsing overlaps solving (in HW: decoder -> FIFO ->
+// dial state machine)
+std::pair<int64_t, int64_t> solve_streaming(const std::string &path) {
+  constexpr size_t BATCH = 64;
+  aoc::FIFO<Rotation, 1024> fifo;
+
+  std::ifstream file(path);
+  if (!file) {
+    throw std::runtime_error("Cannot open file: " + path);
+  }
+  std::exception_ptr parse_error;
+  std::thread parser([&] {
+    aoc::Tracer::instance().name_thread("parser");
+    aoc::TraceScope span("parse");
+    try {
+      std::array<Rotation, BATCH> batch;
+      size_t n = 0;
+      std::string line;
+      while (std::getline(file, line)) {
+        if (line.empty())
+          continue;
+        batch[n++] = {line[0], std::stoi(line.substr(1))};
+        if (n == BATCH) {
+          fifo.push_batch_wait(batch.data(), n);
+          n = 0;
+        }
+      }
+      fifo.push_batch_wait(batch.data(), n);
+    } catch (...) {
+      parse_error = std::current_exception();
+    }
+    fifo.close();
+  });
+
+  DialSimulator dial;
+  std::array<Rotation, BATCH> batch;
+  while (size_t n = fifo.pop_batch_wait(batch.data(), BATCH)) {
+    for (size_t i = 0; i < n; i++) {
+      dial.rotate(batch[i].direction, batch[i].distance);
+    }
+  }
+  parser.join();
+  if (parse_error)
+    std::rethrow_exception(parse_error);
+
+  return {dial.zero_end_count, dial.zero_cross_count};
+}
+
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+    std::cerr << "Usage: " << argv[0]
+              << " <input_file> [--stream] [--cache[=mode]] [--trace=file]\n";
     return 1;
   }
 
-  auto lines = aoc::read_lines(argv[1]);
+  aoc::ResultCache cache(1);
+  bool stream = false;
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--stream") {
+      stream = true;
+    } else if (!cache.parse_option(arg) && !aoc::parse_trace_option(arg)) {
+      std::cerr << "Unknown option: " << arg << "\n";
+      return 1;
+    }
+  }
+
+  if (auto batch = aoc::batch_inputs(argv[1]))
+    return aoc::run_batch<std::vector<std::string>>(
+        *batch, [&](std::vector<std::string> &lines, const std::string &text) {
+          aoc::split_lines(text, lines);
+          auto [part1, part2] = solve(lines);
+          return std::vector<std::string>{std::to_string(part1),
+                                          std::to_string(part2)};
+        });
+
+  cache.open(argv[1]);
 
-  {
-    aoc::Timer t("Both Parts");
-    auto [part1, part2] = solve(lines);
-    std::cout << "Part 1: " << part1 << "\n";
-    std::cout << "Part 2: " << part2 << "\n";
+  if (stream) {
+    cache.both_parts([&] { return solve_streaming(argv[1]); },
+                     "Both Parts (streamed)");
+    return 0;
   }
 
+  auto lines = aoc::read_lines(argv[1]);
+  cache.both_parts([&] { return solve(lines); });
+
   return 0;
 }
@@ -106,9 +106,12 @@ std::pair<int64_t, int64_t> solve(const std::string &input) {
 
   // Parse ranges from input (comma-separated, each is "start-end")
   std::string clean_input;
-  for (char c : input) {
-    if (!std::isspace(c))
-      clean_input += c;
+  {
+    aoc::TraceScope span("parse");
+    for (char c : input) {
+      if (!std::isspace(c))
+        clean_input += c;
+    }
   }
 
   size_t pos = 0;
@@ -141,18 +144,32 @@ std::pair<int64_t, int64_t> solve(const std::string &input) {
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+    std::cerr << "Usage: " << argv[0]
+              << " <input_file> [--cache[=mode]] [--trace=file]\n";
     return 1;
   }
 
-  std::string input = aoc::read_file(argv[1]);
-
-  {
-    aoc::Timer t("Both Parts");
-    auto [part1, part2] = solve(input);
-    std::cout << "Part 1: " << part1 << "\n";
-    std::cout << "Part 2: " << part2 << "\n";
+  aoc::ResultCache cache(2);
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (!cache.parse_option(arg) && !aoc::parse_trace_option(arg)) {
+      std::cerr << "Unknown option: " << arg << "\n";
+      return 1;
+    }
   }
 
+  if (auto batch = aoc::batch_inputs(argv[1]))
+    return aoc::run_batch(
+        *batch, [](std::monostate &, const std::string &text) {
+          auto [part1, part2] = solve(text);
+          return std::vector<std::string>{std::to_string(part1),
+                                          std::to_string(part2)};
+        });
+
+  cache.open(argv[1]);
+
+  std::string input = aoc::read_file(argv[1]);
+  cache.both_parts([&] { return solve(input); });
+
   return 0;
 }
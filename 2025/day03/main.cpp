@@ -35,17 +35,32 @@ int64_t solve_part1(const std::vector<std::string> &lines) {
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+    std::cerr << "Usage: " << argv[0]
+              << " <input_file> [--cache[=mode]] [--trace=file]\n";
     return 1;
   }
 
+  aoc::ResultCache cache(3);
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (!cache.parse_option(arg) && !aoc::parse_trace_option(arg)) {
+      std::cerr << "Unknown option: " << arg << "\n";
+      return 1;
+    }
+  }
+
+  if (auto batch = aoc::batch_inputs(argv[1]))
+    return aoc::run_batch<std::vector<std::string>>(
+        *batch, [&](std::vector<std::string> &lines, const std::string &text) {
+          aoc::split_lines(text, lines);
+          return std::vector<std::string>{std::to_string(solve_part1(lines))};
+        });
+
+  cache.open(argv[1]);
+
   auto lines = aoc::read_lines(argv[1]);
 
-  {
-    aoc::Timer t("Part 1");
-    auto result = solve_part1(lines);
-    std::cout << "Part 1: " << result << "\n";
-  }
+  cache.part(1, [&] { return solve_part1(lines); });
 
   return 0;
 }
@@ -49,58 +49,224 @@ int count_paper_neighbors(const std::array<std::array<char, 3>, 3>& window) {
     return count;
 }
 
-int64_t solve_part1(const std::vector<std::string>& lines) {
-    if (lines.empty()) return 0;
-    
+// Grid with a one-cell halo of empty floor, so the 3x3 window never
+// needs a bounds check (in HW: the zero padding around the line buffer)
+aoc::Grid2D<char> load_grid(const std::vector<std::string>& lines) {
+    aoc::TraceScope span("parse");
     size_t height = lines.size();
-    size_t width = lines[0].size();
+    size_t width = lines.empty() ? 0 : lines[0].size();
+    aoc::Grid2D<char> grid(width, height, '.', 1);
+    for (size_t y = 0; y < height; y++) {
+        std::copy_n(lines[y].begin(), std::min(width, lines[y].size()), grid.row(y));
+    }
+    return grid;
+}
+
+// Bit-packed: each row's "fewer than 4 neighbors" mask comes out of the
+// bit-sliced neighbor counter 64 cells at a time
+int64_t solve_part1_bits(const std::vector<std::string>& lines) {
+    auto paper = aoc::BitGrid2D::from_ascii(lines, '@');
+    std::vector<uint64_t> sparse(paper.words_per_row());
+    int64_t accessible = 0;
+    for (size_t y = 0; y < paper.height(); y++) {
+        paper.neighbors_less_than(y, 4, sparse.data());
+        aoc::BitGrid2D::row_and(sparse.data(), sparse.data(), paper.row(y), sparse.size());
+        accessible += aoc::BitGrid2D::row_popcount(sparse.data(), sparse.size());
+    }
+    return accessible;
+}
+
+int64_t solve_part1_tiled(const std::vector<std::string>& lines) {
+    if (lines.empty()) return 0;
     
-    int64_t accessible_count = 0;
+    auto grid = load_grid(lines);
     
-    // Process grid with 3-row sliding window
-    // In hardware: streaming with line buffers
-    for (size_t y = 0; y < height; y++) {
-        for (size_t x = 0; x < width; x++) {
-            if (lines[y][x] != '@') continue;
-            
-            // Count neighbors in 3x3 window
-            int neighbors = 0;
-            for (int dy = -1; dy <= 1; dy++) {
-                for (int dx = -1; dx <= 1; dx++) {
-                    if (dy == 0 && dx == 0) continue;
-                    int ny = static_cast<int>(y) + dy;
-                    int nx = static_cast<int>(x) + dx;
-                    if (ny >= 0 && ny < static_cast<int>(height) &&
-                        nx >= 0 && nx < static_cast<int>(width) &&
-                        lines[ny][nx] == '@') {
-                        neighbors++;
-                    }
+    // Cache-sized tiles handed out to workers, one count per worker
+    // In hardware: one streaming window per tile
+    std::vector<int64_t> accessible(aoc::hardware_threads(), 0);
+    grid.for_each_tile(accessible.size(), [&](unsigned w, size_t x0, size_t y0,
+                                              size_t x1, size_t y1) {
+        int64_t count = 0;
+        for (size_t y = y0; y < y1; y++) {
+            const char* row = grid.row(y);
+            for (size_t x = x0; x < x1; x++) {
+                // Accessible if fewer than 4 of the 8 neighbors are paper
+                if (row[x] == '@' && grid.count_neighbors(x, y, '@') < 4) {
+                    count++;
                 }
             }
-            
-            // Accessible if fewer than 4 neighbors
-            if (neighbors < 4) {
-                accessible_count++;
-            }
         }
+        accessible[w] += count;
+    });
+    
+    return std::accumulate(accessible.begin(), accessible.end(), int64_t{0});
+}
+
+// ---- Reference pipeline: cell source -> line-buffer stencil -> counter.
+// The grid streams in one padded cell per cycle; the stencil keeps two
+// rows in line buffers and a 3x3 window in registers, and emits one
+// accessible/not bit per interior cell. Target II: 1 cell per cycle.
+
+using CellFIFO = aoc::SimFIFO<char, 4>;
+using ResultFIFO = aoc::SimFIFO<bool, 4>;
+
+class CellSource : public aoc::Module {
+    const aoc::Grid2D<char>& grid_;
+    CellFIFO& out_;
+    ptrdiff_t x_ = -1, y_ = -1;   // Next padded cell, halo included
+    
+public:
+    CellSource(const aoc::Grid2D<char>& grid, CellFIFO& out)
+        : Module("source"), grid_(grid), out_(out) {}
+    
+    aoc::Activity eval() override {
+        if (y_ > static_cast<ptrdiff_t>(grid_.height())) return aoc::Activity::Idle;
+        if (!out_.push(grid_.at(x_, y_))) return aoc::Activity::Backpressure;
+        produced();
+        if (++x_ > static_cast<ptrdiff_t>(grid_.width())) {
+            x_ = -1;
+            y_++;
+        }
+        return aoc::Activity::Busy;
     }
     
-    return accessible_count;
+    bool done() const { return y_ > static_cast<ptrdiff_t>(grid_.height()); }
+};
+
+class Stencil : public aoc::Module {
+    using Window = std::array<std::array<char, 3>, 3>;
+    
+    const CellSource& upstream_;
+    CellFIFO& in_;
+    ResultFIFO& out_;
+    size_t padded_width_;
+    std::vector<char> line0_, line1_;   // The two rows above (in HW: BRAM)
+    size_t px_ = 0, py_ = 0;            // Padded position of the next cell
+    
+public:
+    aoc::Register<Window> window;
+    
+    Stencil(const CellSource& upstream, CellFIFO& in, ResultFIFO& out, size_t padded_width)
+        : Module("stencil"), upstream_(upstream), in_(in), out_(out),
+          padded_width_(padded_width), line0_(padded_width, '.'), line1_(padded_width, '.') {}
+    
+    aoc::Activity eval() override {
+        if (!in_.can_pop()) {
+            return upstream_.done() ? aoc::Activity::Idle : aoc::Activity::Stalled;
+        }
+        bool emits = px_ >= 2 && py_ >= 2;
+        if (emits && !out_.can_push()) return aoc::Activity::Backpressure;
+        
+        char cell;
+        in_.pop(cell);
+        
+        // Shift the window left and bring in the new column
+        Window next = window.get();
+        for (auto& row : next) {
+            row[0] = row[1];
+            row[1] = row[2];
+        }
+        next[0][2] = line0_[px_];
+        next[1][2] = line1_[px_];
+        next[2][2] = cell;
+        window.set(next);
+        line0_[px_] = line1_[px_];
+        line1_[px_] = cell;
+        
+        // Window is centered on padded (px - 1, py - 1): an interior cell
+        if (emits) {
+            out_.push(next[1][1] == '@' && count_paper_neighbors(next) < 4);
+            produced();
+        }
+        if (++px_ == padded_width_) {
+            px_ = 0;
+            py_++;
+        }
+        return aoc::Activity::Busy;
+    }
+    
+    bool done() const { return upstream_.done() && !in_.can_pop(); }
+};
+
+class Counter : public aoc::Module {
+    const Stencil& upstream_;
+    ResultFIFO& in_;
+    
+public:
+    aoc::Register<int64_t> count;
+    
+    Counter(const Stencil& upstream, ResultFIFO& in)
+        : Module("counter"), upstream_(upstream), in_(in) {}
+    
+    aoc::Activity eval() override {
+        bool accessible;
+        if (!in_.pop(accessible)) {
+            return upstream_.done() ? aoc::Activity::Idle : aoc::Activity::Stalled;
+        }
+        count.set(count.get() + accessible);
+        produced();
+        return aoc::Activity::Busy;
+    }
+};
+
+int64_t solve_part1_pipeline(const std::vector<std::string>& lines) {
+    if (lines.empty()) return 0;
+    auto grid = load_grid(lines);
+    
+    CellFIFO cells;
+    ResultFIFO results;
+    CellSource source(grid, cells);
+    Stencil stencil(source, cells, results, grid.width() + 2);
+    Counter counter(stencil, results);
+    
+    aoc::Simulator sim;
+    sim.add(source);
+    sim.add(stencil);
+    sim.add(counter);
+    sim.add_state(cells);
+    sim.add_state(results);
+    sim.add_state(stencil.window);
+    sim.add_state(counter.count);
+    sim.run();
+    sim.report(std::cerr);
+    
+    return counter.count.get();
 }
 
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+        std::cerr << "Usage: " << argv[0] << " <input_file> [--kernel=bits|tiled|pipeline] [--cache[=mode]] [--trace=file]\n";
         return 1;
     }
     
-    auto lines = aoc::read_lines(argv[1]);
+    aoc::ResultCache cache(4);
+    auto kernel = solve_part1_bits;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--kernel=tiled") {
+            kernel = solve_part1_tiled;
+        } else if (arg == "--kernel=pipeline") {
+            kernel = solve_part1_pipeline;
+        } else if (arg != "--kernel=bits" && !cache.parse_option(arg) &&
+                   !aoc::parse_trace_option(arg)) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
     
-    {
-        aoc::Timer t("Part 1");
-        auto result = solve_part1(lines);
-        std::cout << "Part 1: " << result << "\n";
+    if (auto batch = aoc::batch_inputs(argv[1])) {
+        return aoc::run_batch<std::vector<std::string>>(
+            *batch, [&](std::vector<std::string>& lines, const std::string& text) {
+                aoc::split_lines(text, lines);
+                return std::vector<std::string>{std::to_string(kernel(lines))};
+            });
     }
     
+    cache.open(argv[1]);
+    
+    auto lines = aoc::read_lines(argv[1]);
+    
+    cache.part(1, [&] { return kernel(lines); });
+    
     return 0;
 }
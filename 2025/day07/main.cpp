@@ -22,47 +22,44 @@ struct BeamState {
 };
 
 struct TachyonManifold {
-    std::vector<std::string> grid;
+    // One bit per cell. Beams continue through `open` cells and split on
+    // `splitters`; anything else absorbs them.
+    aoc::BitGrid2D splitters;
+    aoc::BitGrid2D open;
     int width;
     int height;
     int start_col;
     
     int64_t count_splits() const {
         int64_t split_count = 0;
+        if (start_col < 0) return 0;
         
-        // Track which columns have active beams
-        // In HW: would be a register per column
-        std::set<int> current_beams;
-        std::set<int> next_beams;
-        
-        // Find start position 'S'
-        current_beams.insert(start_col);
+        // Track which columns have active beams, one bit per column
+        // In HW: a register per column, updated for all columns at once
+        size_t n = splitters.words_per_row();
+        aoc::BitGrid2D beams(width, 1);
+        std::vector<uint64_t> hit(n);
+        beams.set(start_col, 0);
+        uint64_t* current = beams.row(0);
         
         // Process row by row (systolic: one row per clock cycle)
         for (int row = 0; row < height; row++) {
-            next_beams.clear();
+            // Splitter: emit beams left and right
+            aoc::BitGrid2D::row_and(hit.data(), current, splitters.row(row), n);
+            split_count += aoc::BitGrid2D::row_popcount(hit.data(), n);
             
-            for (int col : current_beams) {
-                if (col < 0 || col >= width) continue;
-                
-                char cell = grid[row][col];
-                
-                if (cell == '^') {
-                    // Splitter: emit beams left and right
-                    split_count++;
-                    
-                    if (col - 1 >= 0) next_beams.insert(col - 1);
-                    if (col + 1 < width) next_beams.insert(col + 1);
-                } else if (cell == '.' || cell == 'S' || cell == '|') {
-                    // Empty space or beam: continue downward
-                    next_beams.insert(col);
-                }
+            // Empty space or beam: continue downward; off-edge beams drop
+            bool any = false;
+            for (size_t i = 0; i < n; i++) {
+                current[i] = (current[i] & open.row(row)[i]) |
+                             aoc::BitGrid2D::shifted_up(hit.data(), i) |
+                             aoc::BitGrid2D::shifted_down(hit.data(), i, n);
+                any |= current[i] != 0;
             }
-            
-            current_beams = next_beams;
+            beams.mask_tail(current);
             
             // Early exit if no more beams
-            if (current_beams.empty()) break;
+            if (!any) break;
         }
         
         return split_count;
@@ -71,20 +68,26 @@ struct TachyonManifold {
 
 TachyonManifold parse_input(const std::vector<std::string>& lines) {
     TachyonManifold manifold;
-    manifold.grid = lines;
     manifold.height = lines.size();
-    manifold.width = lines.empty() ? 0 : lines[0].size();
+    manifold.splitters = aoc::BitGrid2D::from_ascii(lines, '^');
+    manifold.width = manifold.splitters.width();
+    manifold.open = aoc::BitGrid2D::from_ascii(lines, '.');
+    for (char c : {'S', '|'}) {
+        auto more = aoc::BitGrid2D::from_ascii(lines, c);
+        for (int row = 0; row < manifold.height; row++) {
+            aoc::BitGrid2D::row_or(manifold.open.row(row), manifold.open.row(row),
+                                   more.row(row), more.words_per_row());
+        }
+    }
     manifold.start_col = -1;
     
     // Find 'S' position
     for (int row = 0; row < manifold.height; row++) {
-        for (int col = 0; col < manifold.width; col++) {
-            if (lines[row][col] == 'S') {
-                manifold.start_col = col;
-                break;
-            }
+        size_t col = lines[row].find('S');
+        if (col != std::string::npos) {
+            manifold.start_col = col;
+            break;
         }
-        if (manifold.start_col >= 0) break;
     }
     
     return manifold;
@@ -95,19 +98,125 @@ int64_t solve_part1(const std::vector<std::string>& lines) {
     return manifold.count_splits();
 }
 
+// ---- Reference pipeline: row source -> systolic beam array. One PE per
+// column holds that column's beam register and talks only to its two
+// neighbors; a whole manifold row is consumed per cycle. Target II: 1 row
+// per cycle.
+
+using RowFIFO = aoc::SimFIFO<std::string, 2>;
+
+class RowSource : public aoc::Module {
+    const std::vector<std::string>& rows_;
+    RowFIFO& out_;
+    size_t next_ = 0;
+    
+public:
+    RowSource(const std::vector<std::string>& rows, RowFIFO& out)
+        : Module("rows"), rows_(rows), out_(out) {}
+    
+    aoc::Activity eval() override {
+        if (done()) return aoc::Activity::Idle;
+        if (!out_.push(rows_[next_])) return aoc::Activity::Backpressure;
+        next_++;
+        produced();
+        return aoc::Activity::Busy;
+    }
+    
+    bool done() const { return next_ == rows_.size(); }
+};
+
+class BeamArray : public aoc::Module {
+    const RowSource& upstream_;
+    RowFIFO& in_;
+    
+public:
+    std::vector<aoc::Register<uint8_t>> beams;   // One per column PE
+    aoc::Register<int64_t> splits;
+    
+    BeamArray(const RowSource& upstream, RowFIFO& in, int width, int start_col)
+        : Module("beam array"), upstream_(upstream), in_(in), beams(width) {
+        if (start_col >= 0 && start_col < width) {
+            beams[start_col].value = beams[start_col].next_value = 1;
+        }
+    }
+    
+    aoc::Activity eval() override {
+        std::string row;
+        if (!in_.pop(row)) {
+            return upstream_.done() ? aoc::Activity::Idle : aoc::Activity::Stalled;
+        }
+        
+        int width = beams.size();
+        auto splits_at = [&](int col) {
+            return col >= 0 && col < width && beams[col].get() &&
+                   col < (int)row.size() && row[col] == '^';
+        };
+        int64_t row_splits = 0;
+        for (int col = 0; col < width; col++) {
+            // Each PE: pass through, or take a beam split off a neighbor
+            char cell = col < (int)row.size() ? row[col] : '.';
+            bool passes = cell == '.' || cell == 'S' || cell == '|';
+            bool beam = (beams[col].get() && passes) || splits_at(col - 1) || splits_at(col + 1);
+            beams[col].set(beam);
+            row_splits += splits_at(col);
+        }
+        splits.set(splits.get() + row_splits);
+        produced();
+        return aoc::Activity::Busy;
+    }
+};
+
+int64_t solve_part1_pipeline(const std::vector<std::string>& lines) {
+    auto manifold = parse_input(lines);
+    
+    RowFIFO rows;
+    RowSource source(lines, rows);
+    BeamArray array(source, rows, manifold.width, manifold.start_col);
+    
+    aoc::Simulator sim;
+    sim.add(source);
+    sim.add(array);
+    sim.add_state(rows);
+    sim.add_state(array.splits);
+    for (auto& beam : array.beams) sim.add_state(beam);
+    sim.run();
+    sim.report(std::cerr);
+    
+    return array.splits.get();
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+        std::cerr << "Usage: " << argv[0] << " <input_file> [--kernel=bits|pipeline] [--cache[=mode]] [--trace=file]\n";
         return 1;
     }
     
-    auto lines = aoc::read_lines(argv[1]);
+    aoc::ResultCache cache(7);
+    auto kernel = solve_part1;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--kernel=pipeline") {
+            kernel = solve_part1_pipeline;
+        } else if (arg != "--kernel=bits" && !cache.parse_option(arg) &&
+                   !aoc::parse_trace_option(arg)) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
     
-    {
-        aoc::Timer t("Part 1");
-        auto result = solve_part1(lines);
-        std::cout << "Part 1: " << result << "\n";
+    if (auto batch = aoc::batch_inputs(argv[1])) {
+        return aoc::run_batch<std::vector<std::string>>(
+            *batch, [&](std::vector<std::string>& lines, const std::string& text) {
+                aoc::split_lines(text, lines);
+                return std::vector<std::string>{std::to_string(kernel(lines))};
+            });
     }
     
+    cache.open(argv[1]);
+    
+    auto lines = aoc::read_lines(argv[1]);
+    
+    cache.part(1, [&] { return kernel(lines); });
+    
     return 0;
 }
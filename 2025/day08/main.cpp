@@ -1,27 +1,50 @@
 // Day 8: Playground - Junction Box Connectivity
 
 #include "aoc.hpp"
-#include <cmath>
+#include <atomic>
+#include <climits>
+#include <tuple>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 struct Point3D {
   int64_t x, y, z;
 
-  double distance_to(const Point3D &other) const {
-    double dx = static_cast<double>(x - other.x);
-    double dy = static_cast<double>(y - other.y);
-    double dz = static_cast<double>(z - other.z);
-    return std::sqrt(dx * dx + dy * dy + dz * dz);
+  // Exact squared distance: orders pairs like the Euclidean distance
+  // without a sqrt or any rounding
+  uint64_t distance2_to(const Point3D &other) const {
+    int64_t dx = x - other.x;
+    int64_t dy = y - other.y;
+    int64_t dz = z - other.z;
+    return static_cast<uint64_t>(dx * dx + dy * dy + dz * dz);
   }
-};
 
-struct Edge {
-  int from, to;
-  double distance;
+  int64_t coord(int axis) const { return axis == 0 ? x : axis == 1 ? y : z; }
+};
 
-  bool operator<(const Edge &other) const { return distance < other.distance; }
+// Edge keyed on exact squared distance, packed for radix sorting
+struct KeyedEdge {
+  uint64_t dist2;
+  uint32_t from, to; // from < to
 };
 
+// Total order shared by every engine. Ties on distance break by
+// (from, to), which makes the MST unique so Kruskal and Boruvka agree.
+bool edge_less(const KeyedEdge &a, const KeyedEdge &b) {
+  return std::tie(a.dist2, a.from, a.to) < std::tie(b.dist2, b.from, b.to);
+}
+
+KeyedEdge make_edge(const std::vector<Point3D> &points, uint32_t i,
+                    uint32_t j) {
+  if (i > j)
+    std::swap(i, j);
+  return {points[i].distance2_to(points[j]), i, j};
+}
+
 std::vector<Point3D> parse_points(const std::vector<std::string> &lines) {
+  aoc::TraceScope span("parse");
   std::vector<Point3D> points;
 
   for (const auto &line : lines) {
@@ -41,6 +64,166 @@ std::vector<Point3D> parse_points(const std::vector<std::string> &lines) {
   return points;
 }
 
+// ============================================================================
+// TILED PAIR KERNEL: closest pairs without materializing all n²/2 edges
+// ============================================================================
+
+// Structure-of-arrays point store for the vectorized distance kernel.
+// Squared distances computed in double are exact integers while every axis
+// spans less than 2^25 (3 * 2^50 < 2^53); `exact` records whether that holds.
+struct PointsSoA {
+  std::vector<double> x, y, z;
+  bool exact = true;
+
+  explicit PointsSoA(const std::vector<Point3D> &points) {
+    int64_t lo[3] = {INT64_MAX, INT64_MAX, INT64_MAX};
+    int64_t hi[3] = {INT64_MIN, INT64_MIN, INT64_MIN};
+    for (const auto &p : points) {
+      x.push_back(static_cast<double>(p.x));
+      y.push_back(static_cast<double>(p.y));
+      z.push_back(static_cast<double>(p.z));
+      for (int a = 0; a < 3; a++) {
+        lo[a] = std::min(lo[a], p.coord(a));
+        hi[a] = std::max(hi[a], p.coord(a));
+      }
+    }
+    for (int a = 0; a < 3 && !points.empty(); a++) {
+      if (hi[a] - lo[a] >= (int64_t{1} << 25))
+        exact = false;
+    }
+  }
+};
+
+// Keeps the `capacity` smallest edges (under edge_less) no heavier than
+// max_dist2. Max-heap, so the current cut-off is always at the front.
+class BoundedHeap {
+  std::vector<KeyedEdge> heap_;
+  size_t capacity_;
+  uint64_t max_dist2_;
+
+public:
+  BoundedHeap(size_t capacity, uint64_t max_dist2)
+      : capacity_(capacity), max_dist2_(max_dist2) {}
+
+  // Edges with a larger squared distance can never be admitted
+  uint64_t threshold() const {
+    return heap_.size() < capacity_ ? max_dist2_ : heap_.front().dist2;
+  }
+
+  void push(const KeyedEdge &e) {
+    if (e.dist2 > max_dist2_ || capacity_ == 0)
+      return;
+    if (heap_.size() < capacity_) {
+      heap_.push_back(e);
+      std::push_heap(heap_.begin(), heap_.end(), edge_less);
+    } else if (edge_less(e, heap_.front())) {
+      std::pop_heap(heap_.begin(), heap_.end(), edge_less);
+      heap_.back() = e;
+      std::push_heap(heap_.begin(), heap_.end(), edge_less);
+    }
+  }
+
+  const std::vector<KeyedEdge> &items() const { return heap_; }
+};
+
+// 256 points * 3 axes * 8 B = 6 KB per block: a row block and a column
+// block stay resident in L1 while the tile is swept.
+constexpr size_t TILE = 256;
+
+// Distances from point i to points [j0, j1), all with j > i
+void scan_row(const PointsSoA &soa, const std::vector<Point3D> &points,
+              uint32_t i, size_t j0, size_t j1, BoundedHeap &heap) {
+  size_t j = j0;
+
+  if (!soa.exact) {
+    for (; j < j1; j++)
+      heap.push({points[i].distance2_to(points[j]), i, uint32_t(j)});
+    return;
+  }
+
+#ifdef __AVX2__
+  // In hardware: 4-lane distance PE, compare against the heap cut-off and
+  // only forward survivors to the (rarely touched) heap
+  __m256d xi = _mm256_set1_pd(soa.x[i]);
+  __m256d yi = _mm256_set1_pd(soa.y[i]);
+  __m256d zi = _mm256_set1_pd(soa.z[i]);
+  alignas(32) double lanes[4];
+  for (; j + 4 <= j1; j += 4) {
+    __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&soa.x[j]), xi);
+    __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&soa.y[j]), yi);
+    __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(&soa.z[j]), zi);
+    __m256d d2 = _mm256_add_pd(
+        _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)),
+        _mm256_mul_pd(dz, dz));
+    __m256d cut = _mm256_set1_pd(static_cast<double>(heap.threshold()));
+    int mask = _mm256_movemask_pd(_mm256_cmp_pd(d2, cut, _CMP_LE_OQ));
+    if (mask == 0)
+      continue;
+    _mm256_store_pd(lanes, d2);
+    for (; mask != 0; mask &= mask - 1) {
+      int b = __builtin_ctz(mask);
+      heap.push({static_cast<uint64_t>(lanes[b]), i, uint32_t(j + b)});
+    }
+  }
+#endif
+
+  for (; j < j1; j++) {
+    double dx = soa.x[j] - soa.x[i];
+    double dy = soa.y[j] - soa.y[i];
+    double dz = soa.z[j] - soa.z[i];
+    double d2 = dx * dx + dy * dy + dz * dz;
+    if (d2 <= static_cast<double>(heap.threshold()))
+      heap.push({static_cast<uint64_t>(d2), i, uint32_t(j)});
+  }
+}
+
+// The k closest pairs with dist2 <= max_dist2, sorted by edge_less.
+// Upper-triangle tiles are handed out dynamically to workers, each of
+// which keeps its own bounded heap; the heaps are merged at the end.
+std::vector<KeyedEdge> closest_pairs(const std::vector<Point3D> &points,
+                                     size_t k,
+                                     uint64_t max_dist2 = UINT64_MAX) {
+  size_t n = points.size();
+  PointsSoA soa(points);
+  size_t blocks = (n + TILE - 1) / TILE;
+
+  std::vector<std::pair<size_t, size_t>> tiles;
+  for (size_t bi = 0; bi < blocks; bi++) {
+    for (size_t bj = bi; bj < blocks; bj++)
+      tiles.push_back({bi, bj});
+  }
+
+  unsigned workers = aoc::hardware_threads();
+  std::vector<BoundedHeap> heaps(workers, BoundedHeap(k, max_dist2));
+  std::atomic<size_t> next_tile{0};
+
+  aoc::parallel_chunks(workers, workers, [&](unsigned w, size_t, size_t) {
+    aoc::TraceScope span("distances");
+    for (size_t t; (t = next_tile.fetch_add(1)) < tiles.size();) {
+      auto [bi, bj] = tiles[t];
+      size_t i1 = std::min(n, (bi + 1) * TILE);
+      size_t j1 = std::min(n, (bj + 1) * TILE);
+      for (size_t i = bi * TILE; i < i1; i++) {
+        size_t j0 = std::max(bj * TILE, i + 1);
+        if (j0 < j1)
+          scan_row(soa, points, uint32_t(i), j0, j1, heaps[w]);
+      }
+    }
+  });
+
+  aoc::TraceScope span("sort");
+  std::vector<KeyedEdge> result;
+  for (const auto &h : heaps)
+    result.insert(result.end(), h.items().begin(), h.items().end());
+  std::sort(result.begin(), result.end(), edge_less);
+  if (result.size() > k)
+    result.resize(k);
+  return result;
+}
+
+// Number of shortest connections made in part 1
+constexpr size_t CONNECTIONS = 1000;
+
 int64_t solve_part1(const std::vector<std::string> &lines) {
   auto points = parse_points(lines);
   int n = points.size();
@@ -48,48 +231,30 @@ int64_t solve_part1(const std::vector<std::string> &lines) {
   if (n < 2)
     return 0;
 
-  // Phase 1: Compute all pairwise distances
-  // In hardware: parallel distance units, O(n²/P) with P PEs
-  std::vector<Edge> edges;
-  edges.reserve(n * (n - 1) / 2);
-
-  for (int i = 0; i < n; i++) {
-    for (int j = i + 1; j < n; j++) {
-      edges.push_back({i, j, points[i].distance_to(points[j])});
-    }
-  }
-
-  // Phase 2: Sort edges by distance
-  // In hardware: streaming merge sort or bitonic sort network
-  std::sort(edges.begin(), edges.end());
+  // Phase 1+2: tiled distance kernel keeps only the shortest connections,
+  // already sorted. In hardware: parallel distance units feeding a top-K
+  // filter instead of a full sort.
+  auto edges = closest_pairs(points, CONNECTIONS);
 
   // Phase 3: Process edges with Union-Find
-  // Process 1000 shortest edges (connections), even if already in same circuit
+  // Every one of them counts, even if already in the same circuit
+  aoc::TraceScope span("union");
   aoc::UnionFind uf(n);
-
-  int edges_processed = 0;
-
   for (const auto &e : edges) {
-    if (edges_processed >= 1000)
-      break;
-
-    // Always try to unite (may or may not change circuit structure)
     uf.unite(e.from, e.to);
-    edges_processed++;
   }
 
-  // Count circuit sizes
-  std::unordered_map<int, int> circuit_sizes;
+  // Circuit sizes are kept at the roots
+  std::vector<int> sizes;
   for (int i = 0; i < n; i++) {
-    circuit_sizes[uf.find(i)]++;
+    if (uf.is_root(i))
+      sizes.push_back(uf.size(i));
   }
 
   // Get three largest circuits
-  std::vector<int> sizes;
-  for (const auto &[root, size] : circuit_sizes) {
-    sizes.push_back(size);
-  }
-  std::sort(sizes.rbegin(), sizes.rend());
+  size_t top = std::min<size_t>(3, sizes.size());
+  std::partial_sort(sizes.begin(), sizes.begin() + top, sizes.end(),
+                    std::greater<int>());
 
   // Multiply top 3
   int64_t result = 1;
@@ -100,19 +265,318 @@ int64_t solve_part1(const std::vector<std::string> &lines) {
   return result;
 }
 
+// ============================================================================
+// PART 2: last edge Kruskal adds before every box is in one circuit
+// ============================================================================
+
+enum class Engine { Auto, Kruskal, Boruvka };
+
+// Above this many points the all-pairs edge list (n²/2 * 16 bytes) is too
+// large to materialize, so Auto switches to Boruvka over a k-d tree.
+constexpr int KRUSKAL_MAX_POINTS = 4096;
+
+// Exact Kruskal: all pairs with integer keys, parallel radix sort, then
+// union until a single component remains.
+KeyedEdge last_edge_kruskal(const std::vector<Point3D> &points) {
+  size_t n = points.size();
+  unsigned workers = aoc::hardware_threads();
+
+  // Phase 1: all pairwise squared distances, rows split across workers.
+  // Row i's edges start at i*(2n-i-1)/2, so rows fill in (i, j) order.
+  std::vector<KeyedEdge> edges(n * (n - 1) / 2);
+  aoc::parallel_chunks(n, workers, [&](unsigned, size_t b, size_t e) {
+    aoc::TraceScope span("distances");
+    for (size_t i = b; i < e; i++) {
+      size_t k = i * (2 * n - i - 1) / 2;
+      for (size_t j = i + 1; j < n; j++) {
+        edges[k++] = {points[i].distance2_to(points[j]),
+                      static_cast<uint32_t>(i), static_cast<uint32_t>(j)};
+      }
+    }
+  });
+
+  // Phase 2: stable radix sort on the 64-bit key preserves the (i, j)
+  // tie order, matching edge_less
+  {
+    aoc::TraceScope span("sort");
+    aoc::radix_sort(edges, [](const KeyedEdge &e) { return e.dist2; }, workers);
+  }
+
+  // Phase 3: union until connected
+  aoc::TraceScope span("union");
+  aoc::UnionFind uf(n);
+  for (const auto &e : edges) {
+    if (uf.unite(e.from, e.to) && uf.components() == 1)
+      return e;
+  }
+  return edges.back();
+}
+
+// Static 3D k-d tree used for Boruvka's nearest-foreign-neighbor queries
+class KdTree {
+  static constexpr uint32_t LEAF_SIZE = 8;
+
+public:
+  struct Node {
+    int64_t lo[3], hi[3];
+    uint32_t begin, end;
+    int32_t left = -1, right = -1;
+  };
+
+  std::vector<Node> nodes;    // Pre-order: parents before children
+  std::vector<uint32_t> order; // Point indices, grouped by leaf
+
+  explicit KdTree(const std::vector<Point3D> &points) : order(points.size()) {
+    aoc::TraceScope span("kd-tree");
+    std::iota(order.begin(), order.end(), 0);
+    nodes.reserve(2 * points.size() / LEAF_SIZE + 1);
+    build(points, 0, order.size());
+  }
+
+private:
+  int32_t build(const std::vector<Point3D> &points, uint32_t begin,
+                uint32_t end) {
+    int32_t id = nodes.size();
+    nodes.push_back({});
+    Node node;
+    node.begin = begin;
+    node.end = end;
+    for (int a = 0; a < 3; a++) {
+      node.lo[a] = INT64_MAX;
+      node.hi[a] = INT64_MIN;
+    }
+    for (uint32_t k = begin; k < end; k++) {
+      for (int a = 0; a < 3; a++) {
+        node.lo[a] = std::min(node.lo[a], points[order[k]].coord(a));
+        node.hi[a] = std::max(node.hi[a], points[order[k]].coord(a));
+      }
+    }
+
+    if (end - begin > LEAF_SIZE) {
+      int axis = 0;
+      for (int a = 1; a < 3; a++) {
+        if (node.hi[a] - node.lo[a] > node.hi[axis] - node.lo[axis])
+          axis = a;
+      }
+      uint32_t mid = begin + (end - begin) / 2;
+      std::nth_element(order.begin() + begin, order.begin() + mid,
+                       order.begin() + end, [&](uint32_t a, uint32_t b) {
+                         return points[a].coord(axis) < points[b].coord(axis);
+                       });
+      node.left = build(points, begin, mid);
+      node.right = build(points, mid, end);
+    }
+    nodes[id] = node;
+    return id;
+  }
+};
+
+// Boruvka EMST: each round every component picks its lightest outgoing
+// edge via k-d tree search, never building the all-pairs list.
+// In hardware: one NN query per PE per round, O(log n) rounds
+KeyedEdge last_edge_boruvka(const std::vector<Point3D> &points) {
+  size_t n = points.size();
+  unsigned workers = aoc::hardware_threads();
+  KdTree tree(points);
+  aoc::ConcurrentUnionFind uf(n);
+
+  // Everything below is indexed by tree position k (leaf order), so a
+  // query walks neighbouring memory; tree.order[k] maps back to the input
+  // index used for tie-breaking.
+  std::vector<Point3D> pts(n);
+  for (size_t k = 0; k < n; k++)
+    pts[k] = points[tree.order[k]];
+
+  std::vector<int> comp(n);
+  std::vector<int> node_comp(tree.nodes.size());
+  std::vector<KeyedEdge> nearest(n);
+  std::vector<KeyedEdge> best(n);
+  // Per-component distance bound shared by all of its points' searches:
+  // a point only needs to beat the best edge its component already has
+  std::vector<std::atomic<uint64_t>> bound(n);
+  KeyedEdge last{0, 0, 0};
+  const KeyedEdge none{UINT64_MAX, UINT32_MAX, UINT32_MAX};
+
+  auto box_dist2 = [](const Point3D &p, const KdTree::Node &node) {
+    uint64_t d2 = 0;
+    for (int a = 0; a < 3; a++) {
+      int64_t c = p.coord(a);
+      int64_t d = c < node.lo[a] ? node.lo[a] - c
+                  : c > node.hi[a] ? c - node.hi[a]
+                                   : 0;
+      d2 += static_cast<uint64_t>(d * d);
+    }
+    return d2;
+  };
+
+  // Nearest point outside comp[q], skipping subtrees wholly inside it.
+  // Pruning is strict, so ties with the bound are still explored.
+  auto search = [&](uint32_t q, KeyedEdge &out) {
+    const Point3D &p = pts[q];
+    int cq = comp[q];
+    std::array<std::pair<int32_t, uint64_t>, 64> stack;
+    size_t top = 0;
+    stack[top++] = {0, box_dist2(p, tree.nodes[0])};
+
+    while (top > 0) {
+      auto [id, d2] = stack[--top];
+      uint64_t limit = std::min(out.dist2, bound[cq].load());
+      if (node_comp[id] == cq || d2 > limit)
+        continue;
+
+      const auto &node = tree.nodes[id];
+      if (node.left < 0) {
+        for (uint32_t k = node.begin; k < node.end; k++) {
+          if (comp[k] == cq)
+            continue;
+          KeyedEdge cand = make_edge(points, tree.order[q], tree.order[k]);
+          if (cand.dist2 <= limit && edge_less(cand, out)) {
+            out = cand;
+            limit = cand.dist2;
+            uint64_t cur = bound[cq].load();
+            while (cand.dist2 < cur &&
+                   !bound[cq].compare_exchange_weak(cur, cand.dist2)) {
+            }
+          }
+        }
+        continue;
+      }
+
+      // Push the farther child first so the nearer one is searched first
+      uint64_t dl = box_dist2(p, tree.nodes[node.left]);
+      uint64_t dr = box_dist2(p, tree.nodes[node.right]);
+      if (dl <= dr) {
+        stack[top++] = {node.right, dr};
+        stack[top++] = {node.left, dl};
+      } else {
+        stack[top++] = {node.left, dl};
+        stack[top++] = {node.right, dr};
+      }
+    }
+  };
+
+  while (uf.components() > 1) {
+    aoc::TraceScope round("round", "components", uf.components());
+    aoc::parallel_chunks(n, workers, [&](unsigned, size_t b, size_t e) {
+      for (size_t k = b; k < e; k++)
+        comp[k] = uf.find(tree.order[k]);
+    });
+
+    // A subtree is skippable when all of its points share one component
+    for (size_t id = tree.nodes.size(); id-- > 0;) {
+      const auto &node = tree.nodes[id];
+      if (node.left < 0) {
+        int c = comp[node.begin];
+        for (uint32_t k = node.begin + 1; k < node.end && c >= 0; k++) {
+          if (comp[k] != c)
+            c = -1;
+        }
+        node_comp[id] = c;
+      } else {
+        int l = node_comp[node.left], r = node_comp[node.right];
+        node_comp[id] = (l == r) ? l : -1;
+      }
+    }
+
+    for (auto &b : bound)
+      b.store(UINT64_MAX);
+
+    aoc::parallel_chunks(n, workers, [&](unsigned, size_t b, size_t e) {
+      aoc::TraceScope span("distances");
+      for (size_t k = b; k < e; k++) {
+        nearest[k] = none;
+        search(k, nearest[k]);
+      }
+    });
+
+    std::fill(best.begin(), best.end(), none);
+    for (size_t k = 0; k < n; k++) {
+      if (edge_less(nearest[k], best[comp[k]]))
+        best[comp[k]] = nearest[k];
+    }
+
+    std::vector<KeyedEdge> chosen;
+    for (size_t c = 0; c < n; c++) {
+      if (best[c].dist2 != UINT64_MAX)
+        chosen.push_back(best[c]);
+    }
+    // Every chosen edge is in the MST, so merge order does not matter:
+    // workers unite their share concurrently and keep the heaviest edge
+    // that joined two components
+    std::vector<KeyedEdge> heaviest(workers, last);
+    aoc::parallel_chunks(chosen.size(), workers,
+                         [&](unsigned w, size_t b, size_t e) {
+                           aoc::TraceScope span("union");
+                           for (size_t i = b; i < e; i++) {
+                             if (uf.unite(chosen[i].from, chosen[i].to) &&
+                                 edge_less(heaviest[w], chosen[i]))
+                               heaviest[w] = chosen[i];
+                           }
+                         });
+    for (const auto &e : heaviest) {
+      if (edge_less(last, e))
+        last = e;
+    }
+  }
+
+  // The heaviest MST edge under edge_less is the one Kruskal adds last
+  return last;
+}
+
+int64_t solve_part2(const std::vector<std::string> &lines, Engine engine) {
+  auto points = parse_points(lines);
+  int n = points.size();
+
+  if (n < 2)
+    return 0;
+
+  if (engine == Engine::Auto)
+    engine = n <= KRUSKAL_MAX_POINTS ? Engine::Kruskal : Engine::Boruvka;
+
+  KeyedEdge last = engine == Engine::Kruskal ? last_edge_kruskal(points)
+                                             : last_edge_boruvka(points);
+  return points[last.from].x * points[last.to].x;
+}
+
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+    std::cerr << "Usage: " << argv[0]
+              << " <input_file> [--engine=auto|kruskal|boruvka]"
+                 " [--cache[=mode]] [--trace=file]\n";
     return 1;
   }
 
+  aoc::ResultCache cache(8);
+  Engine engine = Engine::Auto;
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--engine=kruskal")
+      engine = Engine::Kruskal;
+    else if (arg == "--engine=boruvka")
+      engine = Engine::Boruvka;
+    else if (arg != "--engine=auto" && !cache.parse_option(arg) &&
+             !aoc::parse_trace_option(arg)) {
+      std::cerr << "Unknown option: " << arg << "\n";
+      return 1;
+    }
+  }
+
+  if (auto batch = aoc::batch_inputs(argv[1]))
+    return aoc::run_batch<std::vector<std::string>>(
+        *batch, [&](std::vector<std::string> &lines, const std::string &text) {
+          aoc::split_lines(text, lines);
+          return std::vector<std::string>{
+              std::to_string(solve_part1(lines)),
+              std::to_string(solve_part2(lines, engine))};
+        });
+
+  cache.open(argv[1]);
+
   auto lines = aoc::read_lines(argv[1]);
 
-  {
-    aoc::Timer t("Part 1");
-    auto result = solve_part1(lines);
-    std::cout << "Part 1: " << result << "\n";
-  }
+  cache.part(1, [&] { return solve_part1(lines); });
+
+  cache.part(2, [&] { return solve_part2(lines, engine); });
 
   return 0;
 }
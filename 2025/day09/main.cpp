@@ -7,6 +7,7 @@ struct Tile {
 };
 
 std::vector<Tile> parse_tiles(const std::vector<std::string> &lines) {
+  aoc::TraceScope span("parse");
   std::vector<Tile> tiles;
 
   for (const auto &line : lines) {
@@ -25,42 +26,248 @@ std::vector<Tile> parse_tiles(const std::vector<std::string> &lines) {
   return tiles;
 }
 
-int64_t solve_part1(const std::vector<std::string> &lines) {
-  auto tiles = parse_tiles(lines);
-  int n = tiles.size();
-
-  if (n < 2)
-    return 0;
+int64_t rect_area(const Tile &a, const Tile &b) {
+  // Rectangle area with boundary tiles included
+  int64_t width = std::abs(a.x - b.x) + 1;
+  int64_t height = std::abs(a.y - b.y) + 1;
+  return width * height;
+}
 
+// Reference engine: evaluate all pairs, O(n²)
+int64_t max_area_all_pairs(const std::vector<Tile> &tiles) {
+  int n = tiles.size();
   int64_t max_area = 0;
 
-  // Evaluate all pairs
   for (int i = 0; i < n; i++) {
     for (int j = i + 1; j < n; j++) {
-      // Rectangle area with boundary tiles included
-      int64_t width = std::abs(tiles[i].x - tiles[j].x) + 1;
-      int64_t height = std::abs(tiles[i].y - tiles[j].y) + 1;
-      int64_t area = width * height;
-      max_area = std::max(max_area, area);
+      max_area = std::max(max_area, rect_area(tiles[i], tiles[j]));
     }
   }
 
   return max_area;
 }
 
+// Minimal staircase of the tiles under (sx * x, sy * y): the tiles no other
+// tile dominates toward that corner. Returned in ascending sx * x order.
+std::vector<Tile> staircase(std::vector<Tile> tiles, int sx, int sy) {
+  std::sort(tiles.begin(), tiles.end(), [&](const Tile &a, const Tile &b) {
+    return std::pair(sx * a.x, sy * a.y) < std::pair(sx * b.x, sy * b.y);
+  });
+
+  std::vector<Tile> chain;
+  for (const auto &t : tiles) {
+    if (chain.empty() || sy * t.y < sy * chain.back().y) {
+      chain.push_back(t);
+    }
+  }
+  return chain;
+}
+
+// Staircase engine: O(n log n + h²) where h is the chain length.
+// If b lies up-right of a, moving a down-left or b up-right only grows the
+// rectangle, so an optimal pair is one lower-left/upper-right chain point
+// pair, or one upper-left/lower-right pair. Collinear hull points can be
+// optimal, so the chains (not hull vertices) are the candidate set.
+int64_t max_area_staircase(const std::vector<Tile> &tiles) {
+  auto lower_left = staircase(tiles, 1, 1);
+  auto upper_right = staircase(tiles, -1, -1);
+  auto upper_left = staircase(tiles, 1, -1);
+  auto lower_right = staircase(tiles, -1, 1);
+
+  int64_t max_area = 0;
+  auto search = [&](const std::vector<Tile> &a, const std::vector<Tile> &b) {
+    for (const auto &p : a) {
+      for (const auto &q : b) {
+        max_area = std::max(max_area, rect_area(p, q));
+      }
+    }
+  };
+  search(lower_left, upper_right);
+  search(upper_left, lower_right);
+
+  return max_area;
+}
+
+// ============================================================================
+// PART 2: rectangle must lie inside the red/green polygon
+// ============================================================================
+
+// Coordinate compression for one axis. Each distinct value gets its own
+// cell; a gap cell stands in for the open interval between neighbours only
+// when that interval holds at least one tile, so an empty gap can never be
+// misread as outside. One border cell pads each end for the flood fill.
+struct CompressedAxis {
+  std::vector<int64_t> vals;
+  std::vector<int> pos; // Compressed cell of vals[i]
+  int cells = 0;
+
+  explicit CompressedAxis(std::vector<int64_t> v) : vals(std::move(v)) {
+    std::sort(vals.begin(), vals.end());
+    vals.erase(std::unique(vals.begin(), vals.end()), vals.end());
+    cells = 1;
+    for (size_t i = 0; i < vals.size(); i++) {
+      pos.push_back(cells++);
+      if (i + 1 < vals.size() && vals[i + 1] - vals[i] > 1)
+        cells++;
+    }
+    cells++;
+  }
+
+  int index(int64_t v) const {
+    return pos[std::lower_bound(vals.begin(), vals.end(), v) - vals.begin()];
+  }
+};
+
+// Compressed raster of the polygon with a 2D prefix sum over cells that
+// are outside it, so any rectangle is tested in O(1)
+class PolygonRaster {
+  CompressedAxis xs_, ys_;
+  aoc::Grid2D<int32_t> outside_sum_; // (W+1) x (H+1) inclusive prefix
+
+public:
+  explicit PolygonRaster(const std::vector<Tile> &tiles)
+      : xs_(collect(tiles, &Tile::x)), ys_(collect(tiles, &Tile::y)) {
+    int w = xs_.cells, h = ys_.cells;
+    enum : uint8_t { UNKNOWN, BOUNDARY, OUTSIDE };
+    aoc::Grid2D<uint8_t> cell(w, h, UNKNOWN);
+
+    // Rasterize the red-to-red edges (green boundary tiles)
+    for (size_t i = 0; i < tiles.size(); i++) {
+      const Tile &a = tiles[i];
+      const Tile &b = tiles[(i + 1) % tiles.size()];
+      if (a.x != b.x && a.y != b.y)
+        throw std::runtime_error("Polygon edge is not axis-aligned");
+      int x0 = xs_.index(a.x), x1 = xs_.index(b.x);
+      int y0 = ys_.index(a.y), y1 = ys_.index(b.y);
+      for (int y = std::min(y0, y1); y <= std::max(y0, y1); y++) {
+        for (int x = std::min(x0, x1); x <= std::max(x0, x1); x++) {
+          cell(x, y) = BOUNDARY;
+        }
+      }
+    }
+
+    // Flood fill from the border; whatever it cannot reach is interior.
+    // Explicit stack: the compressed grid can still be large.
+    std::vector<std::pair<int, int>> stack = {{0, 0}};
+    cell(0, 0) = OUTSIDE;
+    const int dx[] = {1, -1, 0, 0}, dy[] = {0, 0, 1, -1};
+    while (!stack.empty()) {
+      auto [x, y] = stack.back();
+      stack.pop_back();
+      for (int d = 0; d < 4; d++) {
+        int nx = x + dx[d], ny = y + dy[d];
+        if (cell.valid(nx, ny) && cell(nx, ny) == UNKNOWN) {
+          cell(nx, ny) = OUTSIDE;
+          stack.push_back({nx, ny});
+        }
+      }
+    }
+
+    outside_sum_.resize(w + 1, h + 1, 0);
+    for (int y = 0; y < h; y++) {
+      for (int x = 0; x < w; x++) {
+        outside_sum_(x + 1, y + 1) = (cell(x, y) == OUTSIDE) +
+                                     outside_sum_(x, y + 1) +
+                                     outside_sum_(x + 1, y) -
+                                     outside_sum_(x, y);
+      }
+    }
+  }
+
+  // True when the rectangle with corners a and b is entirely red/green
+  bool contains(const Tile &a, const Tile &b) const {
+    int x0 = xs_.index(std::min(a.x, b.x)), x1 = xs_.index(std::max(a.x, b.x));
+    int y0 = ys_.index(std::min(a.y, b.y)), y1 = ys_.index(std::max(a.y, b.y));
+    int outside = outside_sum_(x1 + 1, y1 + 1) - outside_sum_(x0, y1 + 1) -
+                  outside_sum_(x1 + 1, y0) + outside_sum_(x0, y0);
+    return outside == 0;
+  }
+
+private:
+  static std::vector<int64_t> collect(const std::vector<Tile> &tiles,
+                                      int64_t Tile::*axis) {
+    std::vector<int64_t> v;
+    for (const auto &t : tiles)
+      v.push_back(t.*axis);
+    return v;
+  }
+};
+
+int64_t solve_part2(const std::vector<std::string> &lines) {
+  auto tiles = parse_tiles(lines);
+  int n = tiles.size();
+
+  if (n < 2)
+    return 0;
+
+  PolygonRaster raster(tiles);
+
+  // Candidate pairs split by first corner across workers. Cheap area test
+  // first, so the raster lookup only runs for pairs that could win.
+  unsigned workers = aoc::hardware_threads();
+  std::vector<int64_t> best(workers, 0);
+  aoc::parallel_chunks(n, workers, [&](unsigned w, size_t b, size_t e) {
+    for (size_t i = b; i < e; i++) {
+      for (int j = i + 1; j < n; j++) {
+        int64_t area = rect_area(tiles[i], tiles[j]);
+        if (area > best[w] && raster.contains(tiles[i], tiles[j]))
+          best[w] = area;
+      }
+    }
+  });
+
+  return *std::max_element(best.begin(), best.end());
+}
+
+enum class Engine { Pairs, Staircase };
+
+int64_t solve_part1(const std::vector<std::string> &lines, Engine engine) {
+  auto tiles = parse_tiles(lines);
+
+  if (tiles.size() < 2)
+    return 0;
+
+  return engine == Engine::Pairs ? max_area_all_pairs(tiles)
+                                 : max_area_staircase(tiles);
+}
+
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+    std::cerr << "Usage: " << argv[0]
+              << " <input_file> [--engine=staircase|pairs] [--cache[=mode]]"
+                 " [--trace=file]\n";
     return 1;
   }
 
+  aoc::ResultCache cache(9);
+  Engine engine = Engine::Staircase;
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--engine=pairs")
+      engine = Engine::Pairs;
+    else if (arg != "--engine=staircase" && !cache.parse_option(arg) &&
+             !aoc::parse_trace_option(arg)) {
+      std::cerr << "Unknown option: " << arg << "\n";
+      return 1;
+    }
+  }
+
+  if (auto batch = aoc::batch_inputs(argv[1]))
+    return aoc::run_batch<std::vector<std::string>>(
+        *batch, [&](std::vector<std::string> &lines, const std::string &text) {
+          aoc::split_lines(text, lines);
+          return std::vector<std::string>{
+              std::to_string(solve_part1(lines, engine)),
+              std::to_string(solve_part2(lines))};
+        });
+
+  cache.open(argv[1]);
+
   auto lines = aoc::read_lines(argv[1]);
 
-  {
-    aoc::Timer t("Part 1");
-    auto result = solve_part1(lines);
-    std::cout << "Part 1: " << result << "\n";
-  }
+  cache.part(1, [&] { return solve_part1(lines, engine); });
+
+  cache.part(2, [&] { return solve_part2(lines); });
 
   return 0;
 }
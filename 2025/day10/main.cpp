@@ -1,110 +1,538 @@
 // Day 10: Factory - Indicator Light Configuration
 
 #include "aoc.hpp"
-#include <bitset>
+#include <bit>
+#include <chrono>
+#include <limits>
 #include <regex>
+#include <span>
+#include <string_view>
 
+// One machine, viewed in place inside a MachineBatch's flat arrays
 struct Machine {
-    std::vector<bool> target;         // Target light pattern
-    std::vector<std::vector<int>> buttons;  // Which lights each button toggles
-    int num_lights;
+    uint64_t target = 0;                   // Target light pattern, bit i = light i
+    std::span<const uint64_t> buttons;     // Lights each button toggles, as masks
+    std::span<const int32_t> joltage;      // Part 2 target count per counter
+    int num_lights = 0;
     
-    // Solve using GF(2) Gaussian elimination
+    // Null spaces up to this dimension are enumerated outright (2^k Gray
+    // code steps); beyond it, meet-in-the-middle over the buttons is cheaper
+    static constexpr int MAX_ENUM_NULLITY = 20;
+    
+    // Solve A x = b over GF(2), lights as rows and buttons as columns
     // Returns minimum button presses, or -1 if unsolvable
     int solve() const {
-        int n = num_lights;
         int m = buttons.size();
+        if (m >= 64) {
+            throw std::runtime_error("GF(2) solver supports up to 63 buttons");
+        }
         
-        // Build augmented matrix [A | b] over GF(2)
-        // Columns are lights, rows are buttons
-        // We want to find which buttons to press (x) such that Ax = b
-        // Where b is target pattern
+        // Augmented row i: bit j set when button j toggles light i, bit m
+        // holds the target. In hardware: one register per row, XOR lanes.
+        const uint64_t rhs_bit = uint64_t{1} << m;
+        std::vector<uint64_t> rows(num_lights, 0);
+        for (int i = 0; i < num_lights; i++) {
+            for (int j = 0; j < m; j++) {
+                if (buttons[j] >> i & 1) rows[i] |= uint64_t{1} << j;
+            }
+            if (target >> i & 1) rows[i] |= rhs_bit;
+        }
         
-        // Actually, we solve the transpose: find minimum weight solution
-        // Use BFS over all possible button combinations
-        // For small m, this is feasible
+        // Gauss-Jordan elimination to reduced row echelon form
+        std::vector<int> pivot_col;  // pivot_col[r] = pivot column of row r
+        int rank = 0;
+        for (int col = 0; col < m && rank < num_lights; col++) {
+            int pivot = -1;
+            for (int r = rank; r < num_lights; r++) {
+                if (rows[r] >> col & 1) { pivot = r; break; }
+            }
+            if (pivot < 0) continue;
+            
+            std::swap(rows[rank], rows[pivot]);
+            for (int r = 0; r < num_lights; r++) {
+                if (r != rank && (rows[r] >> col & 1)) rows[r] ^= rows[rank];
+            }
+            pivot_col.push_back(col);
+            rank++;
+        }
         
-        if (m <= 20) {
-            // BFS by number of presses
-            for (int num_presses = 0; num_presses <= m; num_presses++) {
-                if (try_combinations(num_presses)) {
-                    return num_presses;
-                }
+        // Inconsistent: an all-zero row with the target bit set
+        for (int r = rank; r < num_lights; r++) {
+            if (rows[r] == rhs_bit) return -1;
+        }
+        
+        // Particular solution: free variables 0, each pivot takes its rhs
+        uint64_t x = 0;
+        uint64_t pivots = 0;
+        for (int r = 0; r < rank; r++) {
+            pivots |= uint64_t{1} << pivot_col[r];
+            if (rows[r] & rhs_bit) x |= uint64_t{1} << pivot_col[r];
+        }
+        
+        int nullity = m - rank;
+        if (nullity > MAX_ENUM_NULLITY) {
+            return meet_in_the_middle();
+        }
+        
+        // Null space basis: one vector per free column
+        std::vector<uint64_t> basis;
+        for (int f = 0; f < m; f++) {
+            if (pivots >> f & 1) continue;
+            uint64_t v = uint64_t{1} << f;
+            for (int r = 0; r < rank; r++) {
+                if (rows[r] >> f & 1) v |= uint64_t{1} << pivot_col[r];
             }
-            return -1;
+            basis.push_back(v);
         }
         
-        // For larger m, use Gaussian elimination
-        return gaussian_solve();
+        // Walk the whole coset x + span(basis) in Gray code order,
+        // one XOR per step
+        int best = std::popcount(x);
+        for (uint64_t g = 1; g < (uint64_t{1} << nullity); g++) {
+            x ^= basis[std::countr_zero(g)];
+            best = std::min(best, std::popcount(x));
+        }
+        return best;
     }
     
 private:
-    bool try_combinations(int num_presses) const {
-        // Try all combinations of exactly num_presses buttons
-        std::vector<bool> selected(buttons.size(), false);
-        std::fill(selected.end() - num_presses, selected.end(), true);
+    // Minimum-weight subset via two half tables: 2^(m/2) instead of 2^m
+    int meet_in_the_middle() const {
+        int m = buttons.size();
+        int half = m / 2;
         
-        do {
-            std::vector<bool> state(num_lights, false);
+        std::unordered_map<uint64_t, int> left;
+        for (uint64_t s = 0; s < (uint64_t{1} << half); s++) {
+            uint64_t lights = 0;
+            for (int j = 0; j < half; j++) {
+                if (s >> j & 1) lights ^= buttons[j];
+            }
+            auto [it, inserted] = left.try_emplace(lights, std::popcount(s));
+            if (!inserted) it->second = std::min(it->second, std::popcount(s));
+        }
+        
+        int best = -1;
+        for (uint64_t s = 0; s < (uint64_t{1} << (m - half)); s++) {
+            uint64_t lights = target;
+            for (int j = 0; j < m - half; j++) {
+                if (s >> j & 1) lights ^= buttons[half + j];
+            }
+            auto it = left.find(lights);
+            if (it == left.end()) continue;
+            int presses = it->second + std::popcount(s);
+            if (best < 0 || presses < best) best = presses;
+        }
+        return best;
+    }
+};
+
+// ============================================================================
+// PART 2: joltage counters as an integer linear program
+// ============================================================================
+
+// Dense simplex for  max c.y  s.t.  A y <= b, y >= 0, over doubles.
+// Only ever used as a pruning bound: the exact answer comes from integer
+// arithmetic at the leaves. Phase 1 handles negative right-hand sides via
+// an auxiliary column; Bland-style tie-breaking avoids cycling.
+class LinearProgram {
+    static constexpr double EPS = 1e-9;
+    int rows_, cols_;
+    std::vector<int> basic_, nonbasic_;
+    std::vector<std::vector<double>> t_;  // (rows+2) x (cols+2) tableau
+    
+public:
+    LinearProgram(const std::vector<std::vector<double>>& a,
+                  const std::vector<double>& b, const std::vector<double>& c)
+        : rows_(b.size()), cols_(c.size()), basic_(rows_),
+          nonbasic_(cols_ + 1),
+          t_(rows_ + 2, std::vector<double>(cols_ + 2, 0.0)) {
+        for (int i = 0; i < rows_; i++) {
+            for (int j = 0; j < cols_; j++) t_[i][j] = a[i][j];
+            basic_[i] = cols_ + i;
+            t_[i][cols_] = -1;
+            t_[i][cols_ + 1] = b[i];
+        }
+        for (int j = 0; j < cols_; j++) {
+            nonbasic_[j] = j;
+            t_[rows_][j] = -c[j];
+        }
+        nonbasic_[cols_] = -1;
+        t_[rows_ + 1][cols_] = 1;
+    }
+    
+    // Optimal value; -inf when infeasible, +inf when unbounded
+    double solve() {
+        int r = 0;
+        for (int i = 1; i < rows_; i++) {
+            if (t_[i][cols_ + 1] < t_[r][cols_ + 1]) r = i;
+        }
+        if (rows_ > 0 && t_[r][cols_ + 1] < -EPS) {
+            pivot(r, cols_);
+            if (!run(1) || t_[rows_ + 1][cols_ + 1] < -EPS) {
+                return -std::numeric_limits<double>::infinity();
+            }
+            for (int i = 0; i < rows_; i++) {
+                if (basic_[i] != -1) continue;
+                int s = 0;
+                for (int j = 1; j <= cols_; j++) {
+                    if (better(t_[i][j], j, t_[i][s], s)) s = j;
+                }
+                pivot(i, s);
+            }
+        }
+        if (!run(2)) return std::numeric_limits<double>::infinity();
+        return t_[rows_][cols_ + 1];
+    }
+    
+private:
+    bool better(double v, int j, double w, int s) const {
+        return v < w || (v == w && nonbasic_[j] < nonbasic_[s]);
+    }
+    
+    void pivot(int r, int s) {
+        double inv = 1.0 / t_[r][s];
+        for (int i = 0; i < rows_ + 2; i++) {
+            if (i == r) continue;
+            for (int j = 0; j < cols_ + 2; j++) {
+                if (j != s) t_[i][j] -= t_[r][j] * t_[i][s] * inv;
+            }
+        }
+        for (int j = 0; j < cols_ + 2; j++) {
+            if (j != s) t_[r][j] *= inv;
+        }
+        for (int i = 0; i < rows_ + 2; i++) {
+            if (i != r) t_[i][s] *= -inv;
+        }
+        t_[r][s] = inv;
+        std::swap(basic_[r], nonbasic_[s]);
+    }
+    
+    bool run(int phase) {
+        int obj = phase == 1 ? rows_ + 1 : rows_;
+        while (true) {
+            int s = -1;
+            for (int j = 0; j <= cols_; j++) {
+                if (phase == 2 && nonbasic_[j] == -1) continue;
+                if (s < 0 || better(t_[obj][j], j, t_[obj][s], s)) s = j;
+            }
+            if (t_[obj][s] > -EPS) return true;
             
-            for (size_t i = 0; i < buttons.size(); i++) {
-                if (selected[i]) {
-                    for (int light : buttons[i]) {
-                        state[light] = !state[light];
-                    }
+            int r = -1;
+            for (int i = 0; i < rows_; i++) {
+                if (t_[i][s] < EPS) continue;
+                if (r < 0) { r = i; continue; }
+                double lhs = t_[i][cols_ + 1] / t_[i][s];
+                double rhs = t_[r][cols_ + 1] / t_[r][s];
+                if (lhs < rhs || (lhs == rhs && basic_[i] < basic_[r])) r = i;
+            }
+            if (r < 0) return false;
+            pivot(r, s);
+        }
+    }
+};
+
+// Minimum total presses so every counter hits its joltage exactly.
+// Fraction-free (integer-scaled rational) Gaussian elimination expresses
+// each pivot button as an affine function of the free buttons:
+//     d * x[col] + sum_k a[k] * x[free[k]] = b
+// Branch-and-bound then fixes free buttons one at a time, pruning with the
+// LP relaxation of the remaining ones.
+class JoltageSolver {
+    struct PivotRow {
+        int col;
+        int64_t d, b;
+        std::vector<int64_t> a;  // Coefficient per free button
+    };
+    
+    std::vector<int64_t> ub_;    // Press upper bound per button
+    std::vector<int> free_;
+    std::vector<PivotRow> pivots_;
+    std::vector<int64_t> value_;  // Assignment of the fixed free prefix
+    bool consistent_ = true;
+    int64_t best_ = -1;
+    
+public:
+    explicit JoltageSolver(const Machine& machine) {
+        int m = machine.buttons.size();
+        int n = machine.joltage.size();
+        
+        // A button can't be pressed more often than its smallest counter
+        ub_.assign(m, 0);
+        for (int j = 0; j < m; j++) {
+            int64_t bound = -1;
+            for (int i = 0; i < n; i++) {
+                if (machine.buttons[j] >> i & 1) {
+                    bound = bound < 0 ? machine.joltage[i]
+                                      : std::min<int64_t>(bound, machine.joltage[i]);
                 }
             }
+            ub_[j] = std::max<int64_t>(bound, 0);
+        }
+        
+        // Augmented integer rows: counters x buttons | joltage
+        std::vector<std::vector<int64_t>> rows(n, std::vector<int64_t>(m + 1, 0));
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < m; j++) rows[i][j] = machine.buttons[j] >> i & 1;
+            rows[i][m] = machine.joltage[i];
+        }
+        
+        std::vector<int> pivot_col;
+        int rank = 0;
+        for (int col = 0; col < m && rank < n; col++) {
+            int pivot = -1;
+            for (int r = rank; r < n; r++) {
+                if (rows[r][col] != 0) { pivot = r; break; }
+            }
+            if (pivot < 0) continue;
+            std::swap(rows[rank], rows[pivot]);
             
-            if (state == target) {
-                return true;
+            for (int r = 0; r < n; r++) {
+                if (r == rank || rows[r][col] == 0) continue;
+                int64_t p = rows[rank][col], c = rows[r][col];
+                int64_t g = 0;
+                for (int j = 0; j <= m; j++) {
+                    rows[r][j] = rows[r][j] * p - rows[rank][j] * c;
+                    g = std::gcd(g, rows[r][j]);
+                }
+                if (g > 1) {
+                    for (auto& v : rows[r]) v /= g;
+                }
             }
-        } while (std::next_permutation(selected.begin(), selected.end()));
+            pivot_col.push_back(col);
+            rank++;
+        }
         
-        return false;
+        for (int r = rank; r < n; r++) {
+            if (rows[r][m] != 0) consistent_ = false;
+        }
+        
+        std::vector<bool> is_pivot(m, false);
+        for (int c : pivot_col) is_pivot[c] = true;
+        for (int j = 0; j < m; j++) {
+            if (!is_pivot[j]) free_.push_back(j);
+        }
+        
+        for (int r = 0; r < rank; r++) {
+            int64_t sign = rows[r][pivot_col[r]] < 0 ? -1 : 1;
+            PivotRow row{pivot_col[r], sign * rows[r][pivot_col[r]],
+                         sign * rows[r][m], {}};
+            for (int f : free_) row.a.push_back(sign * rows[r][f]);
+            pivots_.push_back(std::move(row));
+        }
     }
     
-    int gaussian_solve() const {
-        // GF(2) Gaussian elimination
-        int n = num_lights;
-        int m = buttons.size();
-        
-        // Create augmented matrix
-        // Row i represents button i
-        // Columns 0..n-1 are lights, column n is target
-        std::vector<std::vector<bool>> matrix(m, std::vector<bool>(n + 1, false));
+    // Returns -1 if no non-negative integer solution exists
+    int64_t solve() {
+        if (!consistent_) return -1;
+        value_.assign(free_.size(), 0);
+        best_ = -1;
+        search(0);
+        return best_;
+    }
+    
+private:
+    // Right-hand side of pivot row r once the first k free buttons are fixed
+    int64_t residual(const PivotRow& row, size_t k) const {
+        int64_t rhs = row.b;
+        for (size_t j = 0; j < k; j++) rhs -= row.a[j] * value_[j];
+        return rhs;
+    }
+    
+    // LP lower bound on total presses with the first k free buttons fixed;
+    // +inf when the relaxation is infeasible
+    double lp_bound(size_t k) const {
+        size_t rest = free_.size() - k;
+        std::vector<std::vector<double>> a;
+        std::vector<double> b;
+        std::vector<double> c(rest, -1.0);  // Maximize -(objective)
+        double base = 0;
+        for (size_t j = 0; j < k; j++) base += value_[j];
         
-        for (int i = 0; i < m; i++) {
-            for (int light : buttons[i]) {
-                matrix[i][light] = true;
+        for (const auto& row : pivots_) {
+            double rhs = residual(row, k);
+            std::vector<double> coef(rest), neg(rest);
+            for (size_t j = 0; j < rest; j++) {
+                coef[j] = row.a[k + j];
+                neg[j] = -coef[j];
+                c[j] += coef[j] / static_cast<double>(row.d);
             }
+            a.push_back(coef);  // Pivot press count >= 0
+            b.push_back(rhs);
+            a.push_back(neg);   // Pivot press count <= its upper bound
+            b.push_back(static_cast<double>(row.d * ub_[row.col]) - rhs);
+            base += rhs / static_cast<double>(row.d);
+        }
+        for (size_t j = 0; j < rest; j++) {
+            std::vector<double> box(rest, 0.0);
+            box[j] = 1.0;
+            a.push_back(box);
+            b.push_back(static_cast<double>(ub_[free_[k + j]]));
         }
         
-        // Add target as last column
-        for (int j = 0; j < n; j++) {
-            // Target appears in the solution vector
+        double opt = LinearProgram(a, b, c).solve();
+        if (opt == -std::numeric_limits<double>::infinity()) {
+            return std::numeric_limits<double>::infinity();
+        }
+        return base - opt;
+    }
+    
+    void search(size_t k) {
+        if (k == free_.size()) {
+            evaluate();
+            return;
         }
+        double bound = lp_bound(k);
+        if (bound == std::numeric_limits<double>::infinity()) return;
+        if (best_ >= 0 && std::ceil(bound - 1e-6) >= best_) return;
         
-        // This is a complex optimization problem
-        // For now, fall back to brute force for small cases
-        return -1;
+        for (int64_t v = 0; v <= ub_[free_[k]]; v++) {
+            value_[k] = v;
+            search(k + 1);
+        }
+    }
+    
+    // Exact integer check once every free button is fixed
+    void evaluate() {
+        int64_t total = 0;
+        for (int64_t v : value_) total += v;
+        for (const auto& row : pivots_) {
+            int64_t rhs = residual(row, value_.size());
+            if (rhs < 0 || rhs % row.d != 0 || rhs / row.d > ub_[row.col]) return;
+            total += rhs / row.d;
+        }
+        if (best_ < 0 || total < best_) best_ = total;
     }
 };
 
-Machine parse_machine(const std::string& line) {
-    Machine m;
+// ============================================================================
+// PARSING: all machines in flat arrays (one allocation per field, not per
+// button), indexed through offsets like a CSR matrix
+// ============================================================================
+
+struct MachineBatch {
+    std::vector<uint64_t> targets;
+    std::vector<int32_t> num_lights;
+    std::vector<uint64_t> button_masks;
+    std::vector<uint32_t> button_offset{0};   // size() + 1 entries
+    std::vector<int32_t> joltage;
+    std::vector<uint32_t> joltage_offset{0};  // size() + 1 entries
     
+    size_t size() const { return targets.size(); }
+    
+    Machine operator[](size_t i) const {
+        Machine m;
+        m.target = targets[i];
+        m.num_lights = num_lights[i];
+        m.buttons = std::span(button_masks).subspan(
+            button_offset[i], button_offset[i + 1] - button_offset[i]);
+        m.joltage = std::span(joltage).subspan(
+            joltage_offset[i], joltage_offset[i + 1] - joltage_offset[i]);
+        return m;
+    }
+    
+    void end_machine() {
+        button_offset.push_back(button_masks.size());
+        joltage_offset.push_back(joltage.size());
+    }
+    
+    // Empties the batch but keeps every array's capacity for the next parse
+    void clear() {
+        targets.clear();
+        num_lights.clear();
+        button_masks.clear();
+        button_offset.assign(1, 0);
+        joltage.clear();
+        joltage_offset.assign(1, 0);
+    }
+};
+
+// Hand-written single-pass scanner over the whole input buffer. Each line
+// "[.##.] (3) (1,3) ... {3,5,4,7}" appends straight into the batch; lines
+// without '[' are skipped. In hardware: a byte-serial FSM with one
+// accumulator register per field. Parses into `batch`, reusing its arrays.
+void parse_machines(std::string_view text, MachineBatch& batch) {
+    aoc::TraceScope span("parse");
+    batch.clear();
+    size_t lines = std::count(text.begin(), text.end(), '\n') + 1;
+    batch.targets.reserve(lines);
+    batch.num_lights.reserve(lines);
+    batch.button_offset.reserve(lines + 1);
+    batch.joltage_offset.reserve(lines + 1);
+    batch.button_masks.reserve(std::count(text.begin(), text.end(), '('));
+    
+    const char* p = text.data();
+    const char* end = p + text.size();
+    
+    auto read_uint = [&]() {
+        uint32_t v = 0;
+        while (p < end && *p >= '0' && *p <= '9') v = v * 10 + (*p++ - '0');
+        return v;
+    };
+    
+    while (p < end) {
+        // Skip to the light pattern or the end of the line
+        while (p < end && *p != '[' && *p != '\n') p++;
+        if (p == end) break;
+        if (*p == '\n') { p++; continue; }
+        
+        uint64_t target = 0;
+        int lights = 0;
+        for (p++; p < end && *p != ']' && *p != '\n'; p++, lights++) {
+            if (lights >= 64) {
+                throw std::runtime_error("More than 64 lights in a machine");
+            }
+            if (*p == '#') target |= uint64_t{1} << lights;
+        }
+        batch.targets.push_back(target);
+        batch.num_lights.push_back(lights);
+        
+        while (p < end && *p != '\n') {
+            char c = *p++;
+            if (c == '(') {
+                uint64_t mask = 0;
+                while (p < end && *p != ')' && *p != '\n') {
+                    if (*p == ',') { p++; continue; }
+                    uint32_t light = read_uint();
+                    if (light >= 64) {
+                        throw std::runtime_error("Button light index above 63");
+                    }
+                    mask |= uint64_t{1} << light;
+                }
+                batch.button_masks.push_back(mask);
+            } else if (c == '{') {
+                while (p < end && *p != '}' && *p != '\n') {
+                    if (*p == ',') { p++; continue; }
+                    batch.joltage.push_back(read_uint());
+                }
+            }
+        }
+        batch.end_machine();
+    }
+}
+
+MachineBatch parse_machines(std::string_view text) {
+    MachineBatch batch;
+    parse_machines(text, batch);
+    return batch;
+}
+
+// Original std::regex line parser, kept as the --bench-parse baseline
+void parse_machine_regex(const std::string& line, MachineBatch& batch) {
     // Parse [.##.] pattern
     size_t bracket_start = line.find('[');
     size_t bracket_end = line.find(']');
     
+    uint64_t target = 0;
+    int lights = 0;
     if (bracket_start != std::string::npos && bracket_end != std::string::npos) {
         std::string pattern = line.substr(bracket_start + 1, bracket_end - bracket_start - 1);
-        m.num_lights = pattern.size();
-        
-        for (char c : pattern) {
-            m.target.push_back(c == '#');
+        lights = pattern.size();
+        for (size_t i = 0; i < pattern.size(); i++) {
+            if (pattern[i] == '#') target |= uint64_t{1} << i;
         }
     }
+    batch.targets.push_back(target);
+    batch.num_lights.push_back(lights);
     
     // Parse button groups (x,y,z)
     std::regex button_regex(R"(\(([0-9,]+)\))");
@@ -112,53 +540,240 @@ Machine parse_machine(const std::string& line) {
     std::sregex_iterator end;
     
     while (it != end) {
-        std::string button_str = (*it)[1].str();
-        std::vector<int> lights;
-        
-        auto parts = aoc::split(button_str, ',');
-        for (const auto& p : parts) {
-            if (!p.empty()) {
-                lights.push_back(std::stoi(p));
-            }
+        uint64_t mask = 0;
+        for (const auto& p : aoc::split((*it)[1].str(), ',')) {
+            if (!p.empty()) mask |= uint64_t{1} << std::stoi(p);
         }
-        
-        m.buttons.push_back(lights);
+        batch.button_masks.push_back(mask);
         ++it;
     }
     
-    return m;
+    // Parse {a,b,c} joltage targets
+    size_t brace_start = line.find('{');
+    size_t brace_end = line.find('}');
+    if (brace_start != std::string::npos && brace_end != std::string::npos) {
+        auto parts = aoc::split(line.substr(brace_start + 1, brace_end - brace_start - 1), ',');
+        for (const auto& p : parts) {
+            if (!p.empty()) batch.joltage.push_back(std::stoi(p));
+        }
+    }
+    batch.end_machine();
 }
 
-int64_t solve_part1(const std::vector<std::string>& lines) {
+// Times both parsers on `count` machines cycled from the input
+void bench_parse(const std::vector<std::string>& lines, size_t count) {
+    std::vector<std::string> machines;
+    for (const auto& line : lines) {
+        if (!line.empty() && line.find('[') != std::string::npos) machines.push_back(line);
+    }
+    if (machines.empty()) return;
+    
+    std::vector<std::string> big;
+    std::string text;
+    for (size_t i = 0; i < count; i++) {
+        big.push_back(machines[i % machines.size()]);
+        text += big.back();
+        text += '\n';
+    }
+    std::cout << "Parsing " << count << " machines\n";
+    
+    MachineBatch regex_batch;
+    {
+        aoc::Timer t("std::regex parser");
+        for (const auto& line : big) parse_machine_regex(line, regex_batch);
+    }
+    
+    MachineBatch scan_batch;
+    {
+        aoc::Timer t("Streaming scanner");
+        scan_batch = parse_machines(text);
+    }
+    
+    bool same = regex_batch.targets == scan_batch.targets &&
+                regex_batch.button_masks == scan_batch.button_masks &&
+                regex_batch.button_offset == scan_batch.button_offset &&
+                regex_batch.joltage == scan_batch.joltage;
+    std::cout << "Outputs " << (same ? "match" : "DIFFER") << "\n";
+}
+
+// ============================================================================
+// PART 1 BATCH SOLVING: shared memo of machine configurations
+// ============================================================================
+
+// Canonical machine configuration: target mask, then the button masks in
+// sorted order (press order and button order don't change the answer)
+struct MachineKey {
+    std::vector<uint64_t> words;
+    
+    explicit MachineKey(const Machine& m) : words(1, m.target) {
+        words.insert(words.end(), m.buttons.begin(), m.buttons.end());
+        std::sort(words.begin() + 1, words.end());
+    }
+    
+    bool operator==(const MachineKey&) const = default;
+};
+
+struct MachineKeyHash {
+    size_t operator()(const MachineKey& k) const {
+        uint64_t h = 0x9E3779B97F4A7C15ull ^ k.words.size();
+        for (uint64_t w : k.words) {
+            h ^= w + 0x9E3779B97F4A7C15ull + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+
+// Lock-striped result cache shared by all workers. Two workers that miss
+// on the same key at once both solve it; the answers are identical.
+class SolveCache {
+    static constexpr size_t STRIPES = 64;
+    struct Stripe {
+        std::mutex mu;
+        std::unordered_map<MachineKey, int, MachineKeyHash> map;
+    };
+    std::array<Stripe, STRIPES> stripes_;
+    
+public:
+    bool find(const MachineKey& key, size_t hash, int& presses) {
+        auto& stripe = stripes_[hash % STRIPES];
+        std::lock_guard lock(stripe.mu);
+        auto it = stripe.map.find(key);
+        if (it == stripe.map.end()) return false;
+        presses = it->second;
+        return true;
+    }
+    
+    void insert(MachineKey key, size_t hash, int presses) {
+        auto& stripe = stripes_[hash % STRIPES];
+        std::lock_guard lock(stripe.mu);
+        stripe.map.emplace(std::move(key), presses);
+    }
+};
+
+// Machines per pool task: big enough to amortize queueing, small enough to
+// balance uneven machines across workers
+constexpr size_t SHARD_SIZE = 256;
+
+int64_t solve_part1(const MachineBatch& machines, aoc::ThreadPool& pool,
+                    bool report = true) {
+    SolveCache cache;
+    
+    struct WorkerStats {
+        int64_t presses = 0;
+        size_t machines = 0, hits = 0;
+        long long busy_us = 0;
+    };
+    std::vector<WorkerStats> stats(pool.size());
+    
+    for (size_t begin = 0; begin < machines.size(); begin += SHARD_SIZE) {
+        size_t end = std::min(machines.size(), begin + SHARD_SIZE);
+        pool.submit([&, begin, end](unsigned w) {
+            auto start = std::chrono::steady_clock::now();
+            auto& st = stats[w];
+            for (size_t i = begin; i < end; i++) {
+                Machine m = machines[i];
+                MachineKey key(m);
+                size_t hash = MachineKeyHash{}(key);
+                int presses;
+                if (cache.find(key, hash, presses)) {
+                    st.hits++;
+                } else {
+                    presses = m.solve();
+                    cache.insert(std::move(key), hash, presses);
+                }
+                if (presses >= 0) st.presses += presses;
+                st.machines++;
+            }
+            st.busy_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+        });
+    }
+    pool.wait();
+    
     int64_t total_presses = 0;
+    size_t hits = 0;
+    for (const auto& st : stats) {
+        total_presses += st.presses;
+        hits += st.hits;
+    }
     
-    for (const auto& line : lines) {
-        if (line.empty() || line.find('[') == std::string::npos) continue;
-        
-        Machine m = parse_machine(line);
-        int presses = m.solve();
-        
-        if (presses >= 0) {
-            total_presses += presses;
+    if (report) {
+        for (size_t w = 0; w < stats.size(); w++) {
+            const auto& st = stats[w];
+            std::cerr << "  worker " << w << ": " << st.machines << " machines, "
+                      << st.hits << " cache hits, "
+                      << (st.busy_us > 0 ? st.machines * 1000000 / st.busy_us : 0)
+                      << " machines/s\n";
         }
+        std::cerr << "  cache hit rate: "
+                  << (machines.size() ? 100.0 * hits / machines.size() : 0.0)
+                  << "% (" << hits << "/" << machines.size() << ")\n";
     }
     
     return total_presses;
 }
 
+int64_t solve_part2(const MachineBatch& machines) {
+    // Machines are independent: one slice per worker, summed at the end
+    unsigned workers = aoc::hardware_threads();
+    std::vector<int64_t> totals(workers, 0);
+    aoc::parallel_chunks(machines.size(), workers, [&](unsigned w, size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            int64_t presses = JoltageSolver(machines[i]).solve();
+            if (presses >= 0) totals[w] += presses;
+        }
+    });
+    
+    return std::accumulate(totals.begin(), totals.end(), int64_t{0});
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+        std::cerr << "Usage: " << argv[0] << " <input_file> [--bench-parse] [--cache[=mode]] [--trace=file]\n";
         return 1;
     }
     
-    auto lines = aoc::read_lines(argv[1]);
+    aoc::ResultCache cache(10);
+    bool bench = false;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--bench-parse") {
+            bench = true;
+        } else if (!cache.parse_option(arg) && !aoc::parse_trace_option(arg)) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+    
+    if (bench) {
+        bench_parse(aoc::read_lines(argv[1]), 100000);
+        return 0;
+    }
+    
+    if (auto batch = aoc::batch_inputs(argv[1])) {
+        struct BatchState {
+            MachineBatch machines;
+            aoc::ThreadPool pool;
+        };
+        return aoc::run_batch<BatchState>(*batch, [](BatchState& s, const std::string& text) {
+            parse_machines(text, s.machines);
+            return std::vector<std::string>{std::to_string(solve_part1(s.machines, s.pool, false)),
+                                            std::to_string(solve_part2(s.machines))};
+        });
+    }
     
+    cache.open(argv[1]);
+    
+    auto text = aoc::read_file(argv[1]);
+    MachineBatch machines;
     {
-        aoc::Timer t("Part 1");
-        auto result = solve_part1(lines);
-        std::cout << "Part 1: " << result << "\n";
+        aoc::Timer t("Parse");
+        machines = parse_machines(text);
     }
     
+    aoc::ThreadPool pool;
+    cache.part(1, [&] { return solve_part1(machines, pool); });
+    cache.part(2, [&] { return solve_part2(machines); });
+    
     return 0;
 }
@@ -1,45 +1,184 @@
 // Day 11: Reactor - Path Counting in DAG
 
 #include "aoc.hpp"
+#include <string_view>
 
+// Path counts overflow 64 bits on large graphs
+__extension__ typedef unsigned __int128 PathCount;
+
+std::string to_string(PathCount v) {
+    if (v == 0) return "0";
+    std::string digits;
+    while (v > 0) {
+        digits.push_back('0' + static_cast<int>(v % 10));
+        v /= 10;
+    }
+    return {digits.rbegin(), digits.rend()};
+}
+
+// Maps node names to dense integer IDs. Three-letter lowercase names (the
+// puzzle's format) go through a perfect hash into a 26^3 table; anything
+// else falls back to a hash map.
+class NameInterner {
+    static constexpr int PERFECT_SLOTS = 26 * 26 * 26;
+    std::vector<int32_t> perfect_ = std::vector<int32_t>(PERFECT_SLOTS, -1);
+    std::unordered_map<std::string, int32_t> other_;
+    std::vector<std::string> names_;
+    
+    static int perfect_slot(std::string_view name) {
+        if (name.size() != 3) return -1;
+        int slot = 0;
+        for (char c : name) {
+            if (c < 'a' || c > 'z') return -1;
+            slot = slot * 26 + (c - 'a');
+        }
+        return slot;
+    }
+    
+public:
+    // ID for name, assigning the next dense ID on first sight
+    int32_t intern(std::string_view name) {
+        int slot = perfect_slot(name);
+        if (slot >= 0) {
+            if (perfect_[slot] < 0) {
+                perfect_[slot] = names_.size();
+                names_.emplace_back(name);
+            }
+            return perfect_[slot];
+        }
+        auto [it, inserted] = other_.try_emplace(std::string(name), names_.size());
+        if (inserted) names_.emplace_back(name);
+        return it->second;
+    }
+    
+    // ID for name, or -1 if it never appeared
+    int32_t find(std::string_view name) const {
+        int slot = perfect_slot(name);
+        if (slot >= 0) return perfect_[slot];
+        auto it = other_.find(std::string(name));
+        return it == other_.end() ? -1 : it->second;
+    }
+    
+    size_t size() const { return names_.size(); }
+    const std::string& name(int32_t id) const { return names_[id]; }
+};
+
+// Directed graph in compressed sparse row form: the successors of node v
+// are targets[offsets[v] .. offsets[v + 1]). Edges are collected first and
+// compressed once by finalize().
 struct Graph {
-    std::unordered_map<std::string, std::vector<std::string>> adj;
-    std::unordered_set<std::string> nodes;
+    NameInterner names;
+    std::vector<int32_t> offsets;
+    std::vector<int32_t> targets;
+    std::vector<int32_t> topo_order;  // Sources first
+    std::vector<int32_t> topo_index;  // Position of each node in topo_order
     
-    void add_edge(const std::string& from, const std::string& to) {
-        adj[from].push_back(to);
-        nodes.insert(from);
-        nodes.insert(to);
+    void add_edge(std::string_view from, std::string_view to) {
+        int32_t u = names.intern(from);
+        int32_t v = names.intern(to);
+        edge_from_.push_back(u);
+        edge_to_.push_back(v);
     }
     
-    // Count paths using DFS with memoization
-    // In HW: would be DP with topological ordering
-    int64_t count_paths(const std::string& start, const std::string& end) {
-        std::unordered_map<std::string, int64_t> memo;
-        return dfs_count(start, end, memo);
+    size_t num_nodes() const { return names.size(); }
+    
+    // Build the CSR arrays (counting sort by source) and a topological
+    // order with Kahn's algorithm. Throws if the graph has a cycle.
+    void finalize() {
+        size_t n = num_nodes();
+        offsets.assign(n + 1, 0);
+        for (int32_t u : edge_from_) offsets[u + 1]++;
+        for (size_t v = 0; v < n; v++) offsets[v + 1] += offsets[v];
+        
+        targets.resize(edge_to_.size());
+        std::vector<int32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t e = 0; e < edge_from_.size(); e++) {
+            targets[fill[edge_from_[e]]++] = edge_to_[e];
+        }
+        edge_from_.clear();
+        edge_from_.shrink_to_fit();
+        edge_to_.clear();
+        edge_to_.shrink_to_fit();
+        
+        std::vector<int32_t> indegree(n, 0);
+        for (int32_t v : targets) indegree[v]++;
+        topo_order.clear();
+        topo_order.reserve(n);
+        for (size_t v = 0; v < n; v++) {
+            if (indegree[v] == 0) topo_order.push_back(v);
+        }
+        for (size_t head = 0; head < topo_order.size(); head++) {
+            int32_t u = topo_order[head];
+            for (int32_t k = offsets[u]; k < offsets[u + 1]; k++) {
+                if (--indegree[targets[k]] == 0) topo_order.push_back(targets[k]);
+            }
+        }
+        if (topo_order.size() != n) {
+            throw std::runtime_error("Graph has a cycle; path counts are unbounded");
+        }
+        topo_index.assign(n, 0);
+        for (size_t i = 0; i < n; i++) topo_index[topo_order[i]] = i;
     }
     
-private:
-    int64_t dfs_count(const std::string& node, const std::string& end,
-                      std::unordered_map<std::string, int64_t>& memo) {
-        if (node == end) return 1;
+    int64_t count_paths(const std::string& start, const std::string& end) const {
+        return static_cast<int64_t>(count_paths_via(start, {}, end));
+    }
+    
+    // Paths from start to end that visit every waypoint. In a DAG such a
+    // path meets the waypoints in topological order, so the count is the
+    // product of the segment counts start->w1->...->wk->end. All k+1 sinks
+    // are solved in one sweep of the topological order, sinks first, with
+    // one counter lane per sink: paths[v][j] = sum over successors.
+    // In HW: wavefront DP, one topological level per cycle, k+1 lanes wide
+    PathCount count_paths_via(const std::string& start,
+                              const std::vector<std::string>& waypoints,
+                              const std::string& end) const {
+        int32_t s = names.find(start), t = names.find(end);
+        if (s < 0 || t < 0) return 0;
         
-        auto it = memo.find(node);
-        if (it != memo.end()) return it->second;
+        std::vector<int32_t> stops;
+        for (const auto& w : waypoints) {
+            int32_t id = names.find(w);
+            if (id < 0) return 0;
+            stops.push_back(id);
+        }
+        std::sort(stops.begin(), stops.end(), [&](int32_t a, int32_t b) {
+            return topo_index[a] < topo_index[b];
+        });
+        stops.erase(std::unique(stops.begin(), stops.end()), stops.end());
         
-        int64_t total = 0;
-        if (adj.count(node)) {
-            for (const auto& next : adj[node]) {
-                total += dfs_count(next, end, memo);
+        // Segment j runs from sources[j] to sinks[j]
+        std::vector<int32_t> sources = {s}, sinks = stops;
+        sources.insert(sources.end(), stops.begin(), stops.end());
+        sinks.push_back(t);
+        size_t lanes = sinks.size();
+        
+        std::vector<PathCount> paths(num_nodes() * lanes, 0);
+        for (size_t i = topo_order.size(); i-- > 0;) {
+            int32_t u = topo_order[i];
+            PathCount* row = &paths[u * lanes];
+            for (int32_t k = offsets[u]; k < offsets[u + 1]; k++) {
+                const PathCount* next = &paths[targets[k] * lanes];
+                for (size_t j = 0; j < lanes; j++) row[j] += next[j];
+            }
+            for (size_t j = 0; j < lanes; j++) {
+                if (u == sinks[j]) row[j] = 1;
             }
         }
         
-        memo[node] = total;
+        PathCount total = 1;
+        for (size_t j = 0; j < lanes; j++) {
+            total *= paths[sources[j] * lanes + j];
+        }
         return total;
     }
+    
+private:
+    std::vector<int32_t> edge_from_, edge_to_;
 };
 
 Graph parse_graph(const std::vector<std::string>& lines) {
+    aoc::TraceScope span("parse");
     Graph g;
     
     for (const auto& line : lines) {
@@ -49,42 +188,269 @@ Graph parse_graph(const std::vector<std::string>& lines) {
         auto colon_pos = line.find(':');
         if (colon_pos == std::string::npos) continue;
         
-        std::string from = line.substr(0, colon_pos);
-        std::string rest = line.substr(colon_pos + 1);
+        std::string_view view(line);
+        auto is_space = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
         
         // Trim from
-        while (!from.empty() && from.front() == ' ') from.erase(0, 1);
-        while (!from.empty() && from.back() == ' ') from.pop_back();
+        std::string_view from = view.substr(0, colon_pos);
+        while (!from.empty() && is_space(from.front())) from.remove_prefix(1);
+        while (!from.empty() && is_space(from.back())) from.remove_suffix(1);
         
         // Parse destinations
-        std::istringstream iss(rest);
-        std::string to;
-        while (iss >> to) {
-            g.add_edge(from, to);
+        size_t i = colon_pos + 1;
+        while (i < view.size()) {
+            while (i < view.size() && is_space(view[i])) i++;
+            size_t start = i;
+            while (i < view.size() && !is_space(view[i])) i++;
+            if (i > start) g.add_edge(from, view.substr(start, i - start));
         }
     }
     
+    g.finalize();
     return g;
 }
 
+// ============================================================================
+// INCREMENTAL MODE: keep path counts to a fixed target under edge updates
+// ============================================================================
+
+// Maintains paths[v] = number of paths from v to the target while edges
+// are inserted and deleted. Only the ancestors of an edge's source can
+// change, so each update re-sweeps just that ancestor set in topological
+// order (sinks first). Inserts that would close a cycle are rejected.
+class DynamicPathCounter {
+    NameInterner names_;
+    std::vector<std::vector<int32_t>> succ_, pred_;
+    std::vector<PathCount> paths_;
+    std::vector<uint32_t> mark_;  // Epoch stamps: no per-update clearing
+    uint32_t epoch_ = 0;
+    int32_t target_;
+    
+public:
+    DynamicPathCounter(Graph graph, const std::string& target)
+        : names_(std::move(graph.names)) {
+        size_t n = names_.size();
+        succ_.resize(n);
+        pred_.resize(n);
+        for (size_t u = 0; u < n; u++) {
+            for (int32_t k = graph.offsets[u]; k < graph.offsets[u + 1]; k++) {
+                succ_[u].push_back(graph.targets[k]);
+                pred_[graph.targets[k]].push_back(u);
+            }
+        }
+        mark_.assign(n, 0);
+        target_ = node(target);
+        
+        // Initial counts: one full sweep, sinks first
+        paths_.assign(names_.size(), 0);
+        for (size_t i = graph.topo_order.size(); i-- > 0;) {
+            recount(graph.topo_order[i]);
+        }
+    }
+    
+    PathCount paths_from(const std::string& name) const {
+        int32_t id = names_.find(name);
+        return id < 0 ? 0 : paths_[id];
+    }
+    
+    // False (graph unchanged) if the edge would create a cycle
+    bool insert_edge(const std::string& from, const std::string& to) {
+        int32_t u = node(from), v = node(to);
+        if (reaches(v, u)) return false;
+        succ_[u].push_back(v);
+        pred_[v].push_back(u);
+        update_ancestors(u);
+        return true;
+    }
+    
+    // False if there is no such edge
+    bool erase_edge(const std::string& from, const std::string& to) {
+        int32_t u = names_.find(from), v = names_.find(to);
+        if (u < 0 || v < 0) return false;
+        auto it = std::find(succ_[u].begin(), succ_[u].end(), v);
+        if (it == succ_[u].end()) return false;
+        succ_[u].erase(it);
+        pred_[v].erase(std::find(pred_[v].begin(), pred_[v].end(), u));
+        update_ancestors(u);
+        return true;
+    }
+    
+private:
+    int32_t node(const std::string& name) {
+        int32_t id = names_.intern(name);
+        if (static_cast<size_t>(id) >= succ_.size()) {
+            succ_.resize(id + 1);
+            pred_.resize(id + 1);
+            paths_.resize(id + 1, 0);
+            mark_.resize(id + 1, 0);
+        }
+        return id;
+    }
+    
+    void recount(int32_t u) {
+        if (u == target_) {
+            paths_[u] = 1;
+            return;
+        }
+        PathCount total = 0;
+        for (int32_t v : succ_[u]) total += paths_[v];
+        paths_[u] = total;
+    }
+    
+    // Iterative DFS: is `to` reachable from `from`?
+    bool reaches(int32_t from, int32_t to) {
+        uint32_t seen = ++epoch_;
+        std::vector<int32_t> stack = {from};
+        mark_[from] = seen;
+        while (!stack.empty()) {
+            int32_t u = stack.back();
+            stack.pop_back();
+            if (u == to) return true;
+            for (int32_t v : succ_[u]) {
+                if (mark_[v] != seen) {
+                    mark_[v] = seen;
+                    stack.push_back(v);
+                }
+            }
+        }
+        return false;
+    }
+    
+    // Recount u and every ancestor of u. A post-order DFS over successors,
+    // restricted to the ancestor set, visits each node after all of its
+    // affected successors: a local topological order, no global one needed.
+    void update_ancestors(int32_t u) {
+        uint32_t ancestor = ++epoch_;
+        std::vector<int32_t> stack = {u};
+        std::vector<int32_t> affected;
+        mark_[u] = ancestor;
+        while (!stack.empty()) {
+            int32_t a = stack.back();
+            stack.pop_back();
+            affected.push_back(a);
+            for (int32_t p : pred_[a]) {
+                if (mark_[p] != ancestor) {
+                    mark_[p] = ancestor;
+                    stack.push_back(p);
+                }
+            }
+        }
+        
+        uint32_t done = ++epoch_;
+        std::vector<std::pair<int32_t, size_t>> dfs;
+        for (int32_t root : affected) {
+            if (mark_[root] == done) continue;
+            mark_[root] = done;
+            dfs.push_back({root, 0});
+            while (!dfs.empty()) {
+                auto& [a, next] = dfs.back();
+                if (next < succ_[a].size()) {
+                    int32_t v = succ_[a][next++];
+                    if (mark_[v] == ancestor) {
+                        mark_[v] = done;
+                        dfs.push_back({v, 0});
+                    }
+                } else {
+                    recount(a);
+                    dfs.pop_back();
+                }
+            }
+        }
+    }
+};
+
+// Replays an update stream, one result line per entry:
+//     + from to    insert edge (rejected if it would close a cycle)
+//     - from to    delete edge
+//     ? node       paths from node to the target
+// Updates report the count from `source` after they are applied.
+void run_updates(Graph graph, const std::vector<std::string>& updates,
+                 const std::string& source, const std::string& target) {
+    DynamicPathCounter counter(std::move(graph), target);
+    
+    for (const auto& line : updates) {
+        std::istringstream iss(line);
+        std::string op, a, b;
+        if (!(iss >> op >> a)) continue;
+        iss >> b;
+        
+        std::cout << line << " => ";
+        if (op == "?") {
+            std::cout << to_string(counter.paths_from(a)) << "\n";
+            continue;
+        }
+        
+        bool applied = false;
+        if (op == "+") {
+            applied = !b.empty() && counter.insert_edge(a, b);
+            if (!applied) {
+                std::cout << "rejected (would create a cycle)\n";
+                continue;
+            }
+        } else if (op == "-") {
+            applied = !b.empty() && counter.erase_edge(a, b);
+            if (!applied) {
+                std::cout << "rejected (no such edge)\n";
+                continue;
+            }
+        } else {
+            std::cout << "unknown operation\n";
+            continue;
+        }
+        std::cout << source << " -> " << target << ": "
+                  << to_string(counter.paths_from(source)) << "\n";
+    }
+}
+
 int64_t solve_part1(const std::vector<std::string>& lines) {
     Graph g = parse_graph(lines);
     return g.count_paths("you", "out");
 }
 
+// Server-to-output paths through both the DAC and the FFT
+PathCount solve_part2(const std::vector<std::string>& lines) {
+    Graph g = parse_graph(lines);
+    return g.count_paths_via("svr", {"dac", "fft"}, "out");
+}
+
 int main(int argc, char* argv[]) {
     if (argc < 2) {
-        std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+        std::cerr << "Usage: " << argv[0] << " <input_file> [--updates=<file>] [--cache[=mode]] [--trace=file]\n";
         return 1;
     }
     
+    aoc::ResultCache cache(11);
+    std::string updates;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--updates=", 0) == 0) {
+            updates = arg.substr(10);
+        } else if (!cache.parse_option(arg) && !aoc::parse_trace_option(arg)) {
+            std::cerr << "Unknown option: " << arg << "\n";
+            return 1;
+        }
+    }
+    
+    if (auto batch = aoc::batch_inputs(argv[1])) {
+        return aoc::run_batch<std::vector<std::string>>(
+            *batch, [&](std::vector<std::string>& lines, const std::string& text) {
+                aoc::split_lines(text, lines);
+                return std::vector<std::string>{std::to_string(solve_part1(lines)),
+                                                to_string(solve_part2(lines))};
+            });
+    }
+    
     auto lines = aoc::read_lines(argv[1]);
     
-    {
-        aoc::Timer t("Part 1");
-        auto result = solve_part1(lines);
-        std::cout << "Part 1: " << result << "\n";
+    if (!updates.empty()) {
+        aoc::Timer t("Updates");
+        run_updates(parse_graph(lines), aoc::read_lines(updates), "you", "out");
+        return 0;
     }
+    cache.open(argv[1]);
+    
+    cache.part(1, [&] { return solve_part1(lines); });
+    cache.part(2, [&] { return to_string(solve_part2(lines)); });
     
     return 0;
 }
@@ -1,14 +1,18 @@
 // Day 12: Christmas Tree Farm - Present Packing
 
 #include "aoc.hpp"
+#include <atomic>
+#include <bit>
 #include <chrono>
 #include <climits>
+#include <optional>
 #include <set>
 
 struct Shape {
   int index;
   std::vector<std::pair<int, int>> cells;
   int width = 0, height = 0;
+  std::vector<uint64_t> row_masks; // Bit dx of row dy set for each cell
 
   std::vector<Shape> all_orientations() const {
     std::vector<Shape> orientations;
@@ -67,68 +71,789 @@ struct Shape {
       height = std::max(height, dy + 1);
     }
     std::sort(cells.begin(), cells.end());
+
+    if (width > 64)
+      throw std::runtime_error("Shapes wider than 64 cells are not supported");
+    row_masks.assign(height, 0);
+    for (const auto &[dx, dy] : cells) {
+      row_masks[dy] |= uint64_t{1} << dx;
+    }
   }
 
   int cell_count() const { return cells.size(); }
+
+  // |black - white| cells under a checkerboard coloring. Translating,
+  // rotating or flipping the shape at most swaps the colors.
+  int color_imbalance() const {
+    int diff = 0;
+    for (const auto &[dx, dy] : cells)
+      diff += ((dx + dy) & 1) ? -1 : 1;
+    return std::abs(diff);
+  }
 };
 
+// Occupancy as a bitboard (aoc::BitGrid2D): bit x of row y is set when
+// cell (x, y) is filled. Rows wider than 64 cells span several words. Placement tests
+// are one AND per shape row (two when the shape straddles a word
+// boundary); place/unplace are the same XOR.
 struct Region {
   int width, height;
   std::vector<int> piece_counts;
-  std::vector<std::vector<bool>> grid;
+  int words_per_row = 1;
+  aoc::BitGrid2D cells;
+
+  void clear() {
+    cells = aoc::BitGrid2D(width, height);
+    words_per_row = cells.words_per_row();
+  }
 
+  // The caller keeps the shape's bounding box inside the region
   bool can_place(const Shape &shape, int x, int y) const {
-    for (const auto &[dx, dy] : shape.cells) {
-      int nx = x + dx, ny = y + dy;
-      if (nx < 0 || nx >= width || ny < 0 || ny >= height)
+    int word = x >> 6, shift = x & 63;
+    const uint64_t *row = cells.row(y) + word;
+    for (int dy = 0; dy < shape.height; dy++, row += words_per_row) {
+      uint64_t m = shape.row_masks[dy];
+      if (row[0] & (m << shift))
         return false;
-      if (grid[ny][nx])
+      if (shift && (m >> (64 - shift)) && (row[1] & (m >> (64 - shift))))
         return false;
     }
     return true;
   }
 
-  void place(const Shape &shape, int x, int y) {
-    for (const auto &[dx, dy] : shape.cells) {
-      grid[y + dy][x + dx] = true;
+  // Single-word rows only: bit x set when the shape fits with its corner at
+  // (x, y). Every x is tested at once by shifting each occupied row right
+  // by the offsets of the shape's cells in that row.
+  uint64_t fit_mask(const Shape &shape, int y) const {
+    int span = width - shape.width + 1;
+    uint64_t blocked = 0;
+    for (int dy = 0; dy < shape.height; dy++) {
+      uint64_t row = cells.row(y + dy)[0];
+      for (uint64_t m = shape.row_masks[dy]; m; m &= m - 1) {
+        blocked |= row >> std::countr_zero(m);
+      }
+    }
+    uint64_t in_bounds = span >= 64 ? ~uint64_t{0} : (uint64_t{1} << span) - 1;
+    return ~blocked & in_bounds;
+  }
+
+  // Calls f(x) for each x where the shape fits with its corner at (x, y),
+  // stopping early (and returning true) once f returns true. The fit set
+  // is computed up front, so f may place and unplace pieces meanwhile.
+  template <typename F> bool for_each_fit(const Shape &shape, int y, F &&f) {
+    if (words_per_row == 1) {
+      for (uint64_t fits = fit_mask(shape, y); fits; fits &= fits - 1) {
+        if (f(std::countr_zero(fits)))
+          return true;
+      }
+      return false;
+    }
+    for (int x = 0; x <= width - shape.width; x++) {
+      if (can_place(shape, x, y) && f(x))
+        return true;
     }
+    return false;
+  }
+
+  bool filled(int x, int y) const { return cells.get(x, y); }
+
+  void place(const Shape &shape, int x, int y) { toggle(shape, x, y); }
+  void unplace(const Shape &shape, int x, int y) { toggle(shape, x, y); }
+
+private:
+  void toggle(const Shape &shape, int x, int y) {
+    int word = x >> 6, shift = x & 63;
+    uint64_t *row = cells.row(y) + word;
+    for (int dy = 0; dy < shape.height; dy++, row += words_per_row) {
+      uint64_t m = shape.row_masks[dy];
+      row[0] ^= m << shift;
+      if (shift && (m >> (64 - shift)))
+        row[1] ^= m >> (64 - shift);
+    }
+  }
+};
+
+enum class Verdict { Fits, NoFit, Unknown };
+
+// Which stage of the pipeline settled a region, cheapest first
+enum class Tier { Area, Boxes, Coloring, Search };
+
+struct SearchStats {
+  uint64_t nodes = 0;
+  uint64_t backtracks = 0; // Placements undone after their subtree failed
+  uint64_t max_depth = 0;
+  uint64_t table_hits = 0, table_misses = 0;
+
+  SearchStats &operator+=(const SearchStats &o) {
+    nodes += o.nodes;
+    backtracks += o.backtracks;
+    max_depth = std::max(max_depth, o.max_depth);
+    table_hits += o.table_hits;
+    table_misses += o.table_misses;
+    return *this;
+  }
+};
+
+struct FitResult {
+  Verdict verdict = Verdict::NoFit;
+  Tier tier = Tier::Search;
+  SearchStats stats = {};
+};
+
+// What a search may spend. The node budget is what makes answers
+// reproducible: the same input gives up at the same node on any machine
+// under any load. A wall-clock limit can be added on top, but then an
+// Unknown verdict depends on speed again.
+struct SearchLimits {
+  uint64_t node_budget = 0; // 0: unlimited
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+  const std::atomic<bool> *cancel = nullptr; // Set once a sibling packs
+};
+
+// Node counter that enforces SearchLimits. Charging a node is an
+// increment and a compare; the clock and the cancel flag are only read
+// every POLL_INTERVAL nodes.
+class SearchBudget {
+  SearchLimits limits_;
+  uint64_t nodes_ = 0, next_poll_ = 1; // Poll on the first node too
+  bool exhausted_ = false, cancelled_ = false;
+
+public:
+  static constexpr uint64_t POLL_INTERVAL = 4096;
+
+  explicit SearchBudget(const SearchLimits &limits) : limits_(limits) {}
+
+  // Count one node; false once the search must unwind
+  bool charge() {
+    if (++nodes_ > limits_.node_budget && limits_.node_budget)
+      exhausted_ = true;
+    if (nodes_ >= next_poll_) {
+      next_poll_ += POLL_INTERVAL;
+      if (limits_.deadline &&
+          std::chrono::steady_clock::now() > *limits_.deadline)
+        exhausted_ = true;
+      if (limits_.cancel && limits_.cancel->load(std::memory_order_relaxed))
+        cancelled_ = true;
+    }
+    return !stopped();
+  }
+
+  bool stopped() const { return exhausted_ || cancelled_; }
+  // Ran out of nodes or time: the search proved nothing
+  bool exhausted() const { return exhausted_; }
+  uint64_t nodes() const { return nodes_; }
+};
+
+// Exact cover with dancing links (Knuth's Algorithm X), adapted to packing:
+//  - every cell is a column that may stay empty (a secondary column), so a
+//    branch either covers it with a placement or leaves it blank;
+//  - each piece type is a column with a multiplicity: choosing a placement
+//    decrements its count and the column is only covered at zero, so the
+//    copies of one piece are interchangeable and never permuted;
+//  - branching picks the cell with the fewest options, ties to the first
+//    cell in scan order;
+//  - dead space prunes: cells no remaining placement can reach must stay
+//    empty, and there are only free_cells - remaining_area blanks to spend.
+class DlxPacker {
+  std::vector<int> left_, right_, up_, down_, col_, size_;
+  std::vector<int> row_type_;  // Piece type of each row's first node
+  std::vector<int> row_start_; // First node of each row
+  std::vector<int> node_row_;
+  std::vector<int> remaining_; // Copies still to place, per type
+  std::vector<int> type_area_;
+  int cells_, types_, root_;
+  int free_cells_, remaining_area_, pieces_left_ = 0;
+
+  SearchBudget budget_;
+  SearchStats stats_;
+  uint64_t depth_ = 0;
+
+public:
+  DlxPacker(const Region &region,
+            const std::vector<std::vector<Shape>> &all_shapes,
+            const std::vector<int> &shape_sizes,
+            const SearchLimits &limits)
+      : cells_(region.width * region.height), types_(all_shapes.size()),
+        root_(cells_ + types_), budget_(limits) {
+    // Headers: cells in the root list, type columns self-linked outside it
+    int headers = root_ + 1;
+    for (int c = 0; c < headers; c++) {
+      left_.push_back(c);
+      right_.push_back(c);
+      up_.push_back(c);
+      down_.push_back(c);
+      col_.push_back(c);
+      size_.push_back(0);
+      node_row_.push_back(-1);
+    }
+    for (int c = 0; c < cells_; c++) {
+      left_[c] = c == 0 ? root_ : c - 1;
+      right_[c] = c + 1 == cells_ ? root_ : c + 1;
+    }
+    left_[root_] = cells_ > 0 ? cells_ - 1 : root_;
+    right_[root_] = cells_ > 0 ? 0 : root_;
+
+    remaining_.assign(types_, 0);
+    type_area_.assign(types_, 0);
+    remaining_area_ = 0;
+    for (int t = 0; t < types_; t++) {
+      if (t < static_cast<int>(region.piece_counts.size()))
+        remaining_[t] = region.piece_counts[t];
+      type_area_[t] = shape_sizes[t];
+      remaining_area_ += remaining_[t] * type_area_[t];
+      pieces_left_ += remaining_[t];
+    }
+    free_cells_ = cells_;
+
+    // One row per (type, orientation, position); size the arrays up front
+    size_t rows = 0, nodes = headers;
+    for (int t = 0; t < types_; t++) {
+      if (remaining_[t] == 0)
+        continue;
+      for (const auto &orient : all_shapes[t]) {
+        size_t places = std::max(0, region.height - orient.height + 1) *
+                        std::max(0, region.width - orient.width + 1);
+        rows += places;
+        nodes += places * (orient.cells.size() + 1);
+      }
+    }
+    for (auto *v : {&left_, &right_, &up_, &down_, &col_, &node_row_})
+      v->reserve(nodes);
+    row_start_.reserve(rows);
+    row_type_.reserve(rows);
+
+    std::vector<int> cols;
+    for (int t = 0; t < types_; t++) {
+      if (remaining_[t] == 0)
+        continue;
+      for (const auto &orient : all_shapes[t]) {
+        for (int y = 0; y + orient.height <= region.height; y++) {
+          for (int x = 0; x + orient.width <= region.width; x++) {
+            cols.clear();
+            for (const auto &[dx, dy] : orient.cells)
+              cols.push_back((y + dy) * region.width + (x + dx));
+            cols.push_back(cells_ + t);
+            add_row(cols, t);
+          }
+        }
+      }
+    }
+  }
+
+  Verdict solve() {
+    bool found = search();
+    stats_.nodes = budget_.nodes();
+    if (found)
+      return Verdict::Fits;
+    return budget_.exhausted() ? Verdict::Unknown : Verdict::NoFit;
+  }
+  const SearchStats &stats() const { return stats_; }
+
+private:
+  void add_row(const std::vector<int> &cols, int type) {
+    int first = left_.size();
+    int row = row_start_.size();
+    row_start_.push_back(first);
+    row_type_.push_back(type);
+    for (size_t k = 0; k < cols.size(); k++) {
+      int node = first + k, c = cols[k];
+      left_.push_back(k == 0 ? first + cols.size() - 1 : node - 1);
+      right_.push_back(k + 1 == cols.size() ? first : node + 1);
+      up_.push_back(up_[c]);
+      down_.push_back(c);
+      down_[up_[c]] = node;
+      up_[c] = node;
+      col_.push_back(c);
+      node_row_.push_back(row);
+      size_[c]++;
+    }
+  }
+
+  void cover(int c) {
+    right_[left_[c]] = right_[c];
+    left_[right_[c]] = left_[c];
+    for (int i = down_[c]; i != c; i = down_[i]) {
+      for (int j = right_[i]; j != i; j = right_[j]) {
+        down_[up_[j]] = down_[j];
+        up_[down_[j]] = up_[j];
+        size_[col_[j]]--;
+      }
+    }
+  }
+
+  void uncover(int c) {
+    for (int i = up_[c]; i != c; i = up_[i]) {
+      for (int j = left_[i]; j != i; j = left_[j]) {
+        size_[col_[j]]++;
+        down_[up_[j]] = j;
+        up_[down_[j]] = j;
+      }
+    }
+    right_[left_[c]] = c;
+    left_[right_[c]] = c;
+  }
+
+  bool search() {
+    if (pieces_left_ == 0)
+      return true;
+    if (!budget_.charge())
+      return false;
+    stats_.max_depth = std::max(stats_.max_depth, depth_);
+
+    int slack = free_cells_ - remaining_area_;
+    if (slack < 0)
+      return false;
+    for (int t = 0; t < types_; t++) {
+      if (remaining_[t] > 0 && size_[cells_ + t] == 0)
+        return false;
+    }
+
+    int best = -1, best_options = INT_MAX, dead = 0;
+    for (int c = right_[root_]; c != root_; c = right_[c]) {
+      if (size_[c] == 0)
+        dead++;
+      int options = size_[c] + (slack > 0);
+      if (options < best_options) {
+        best = c;
+        best_options = options;
+      }
+    }
+    if (dead > slack || best < 0 || best_options == 0)
+      return false;
+
+    // Cover `best` with each placement through it
+    cover(best);
+    for (int i = down_[best]; i != best; i = down_[i]) {
+      int type = row_type_[node_row_[i]];
+      int type_col = cells_ + type;
+      for (int j = right_[i]; j != i; j = right_[j]) {
+        if (col_[j] != type_col)
+          cover(col_[j]);
+      }
+      bool exhausted = --remaining_[type] == 0;
+      if (exhausted)
+        cover(type_col);
+      free_cells_ -= type_area_[type];
+      remaining_area_ -= type_area_[type];
+      pieces_left_--;
+
+      depth_++;
+      bool found = search();
+      depth_--;
+
+      pieces_left_++;
+      remaining_area_ += type_area_[type];
+      free_cells_ += type_area_[type];
+      if (exhausted)
+        uncover(type_col);
+      remaining_[type]++;
+      for (int j = left_[i]; j != i; j = left_[j]) {
+        if (col_[j] != type_col)
+          uncover(col_[j]);
+      }
+      if (found) {
+        uncover(best);
+        return true;
+      }
+      if (budget_.stopped())
+        break;
+      stats_.backtracks++;
+    }
+
+    // Or leave `best` empty, spending one blank
+    bool found = false;
+    if (slack > 0 && !budget_.stopped()) {
+      free_cells_--;
+      depth_++;
+      found = search();
+      depth_--;
+      free_cells_++;
+    }
+    uncover(best);
+    return found;
+  }
+};
+
+enum class Engine { Backtrack, Dlx };
+
+uint64_t splitmix64(uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+// Zobrist keys for one region and piece order. A search state hashes to
+// the XOR of its occupied cells' keys and the key of its remaining piece
+// multiset, so placing a piece updates the hash with one XOR per cell.
+struct ZobristKeys {
+  int width;
+  std::vector<uint64_t> cells; // Indexed by y * width + x
+  std::vector<uint64_t> rest;  // rest[idx] hashes the multiset pieces[idx..]
+
+  ZobristKeys(const Region &region, const std::vector<int> &pieces)
+      : width(region.width), cells(region.width * region.height),
+        rest(pieces.size() + 1, 0) {
+    for (size_t c = 0; c < cells.size(); c++)
+      cells[c] = splitmix64(c);
+    // Multiset as (shape, copies left) pairs, on a separate key stream
+    auto count_key = [](int shape, uint64_t n) {
+      return n ? splitmix64(~(static_cast<uint64_t>(shape) << 32 | n)) : 0;
+    };
+    std::unordered_map<int, uint64_t> left;
+    for (size_t idx = pieces.size(); idx-- > 0;) {
+      uint64_t n = ++left[pieces[idx]];
+      rest[idx] = rest[idx + 1] ^ count_key(pieces[idx], n - 1) ^
+                  count_key(pieces[idx], n);
+    }
+  }
+
+  uint64_t board(const Region &region) const {
+    uint64_t h = 0;
+    for (int y = 0; y < region.height; y++)
+      for (int x = 0; x < region.width; x++)
+        if (region.filled(x, y))
+          h ^= cells[y * width + x];
+    return h;
   }
 
-  void unplace(const Shape &shape, int x, int y) {
-    for (const auto &[dx, dy] : shape.cells) {
-      grid[y + dy][x + dx] = false;
+  uint64_t shape(const Shape &shape, int x, int y) const {
+    uint64_t h = 0;
+    for (const auto &[dx, dy] : shape.cells)
+      h ^= cells[(y + dy) * width + x + dx];
+    return h;
+  }
+};
+
+// Fixed-size set of refuted states. Each slot holds one full 64-bit key
+// and is simply overwritten on collision, so lookups never block and the
+// table can be shared by every searcher working on the same region.
+class TranspositionTable {
+  std::vector<std::atomic<uint64_t>> slots_;
+  uint64_t mask_;
+
+  // Slots start at 0, so never store 0 as a key
+  static uint64_t nonzero(uint64_t key) { return key ? key : 1; }
+
+public:
+  explicit TranspositionTable(int log2_slots)
+      : slots_(size_t{1} << log2_slots), mask_((uint64_t{1} << log2_slots) - 1) {
+  }
+
+  bool refuted(uint64_t key) const {
+    return slots_[key & mask_].load(std::memory_order_relaxed) == nonzero(key);
+  }
+  void refute(uint64_t key) {
+    slots_[key & mask_].store(nonzero(key), std::memory_order_relaxed);
+  }
+};
+
+// Mutable state of one backtracking search. Each thread (or each parallel
+// subtree) owns one, along with its own copy of the region.
+class BacktrackSearch {
+  const std::vector<std::vector<Shape>> &all_shapes_;
+  const std::vector<int> &pieces_;
+  Region &region_;
+  SearchBudget budget_;
+  const ZobristKeys *keys_ = nullptr;
+  TranspositionTable *table_ = nullptr;
+  uint64_t board_hash_ = 0;
+  SearchStats stats_;
+
+public:
+  BacktrackSearch(const std::vector<std::vector<Shape>> &all_shapes,
+                  const std::vector<int> &pieces, Region &region,
+                  const SearchLimits &limits)
+      : all_shapes_(all_shapes), pieces_(pieces), region_(region),
+        budget_(limits) {}
+
+  // Skip states already refuted by this or any other search sharing table
+  void use_table(const ZobristKeys &keys, TranspositionTable &table) {
+    keys_ = &keys;
+    table_ = &table;
+    board_hash_ = keys.board(region_);
+  }
+
+  // Place pieces[idx..] into the region
+  Verdict run(size_t idx) {
+    bool found = solve(idx);
+    stats_.nodes = budget_.nodes();
+    if (found)
+      return Verdict::Fits;
+    return budget_.exhausted() ? Verdict::Unknown : Verdict::NoFit;
+  }
+
+  const SearchStats &stats() const { return stats_; }
+
+private:
+  bool solve(size_t idx) {
+    if (idx >= pieces_.size())
+      return true;
+    if (!budget_.charge())
+      return false;
+    stats_.max_depth = std::max<uint64_t>(stats_.max_depth, idx);
+
+    int shape_idx = pieces_[idx];
+    if (shape_idx >= static_cast<int>(all_shapes_.size()))
+      return false;
+
+    uint64_t key = 0;
+    if (table_) {
+      key = board_hash_ ^ keys_->rest[idx];
+      if (table_->refuted(key)) {
+        stats_.table_hits++;
+        return false;
+      }
+      stats_.table_misses++;
+    }
+
+    for (const auto &orient : all_shapes_[shape_idx]) {
+      for (int y = 0; y <= region_.height - orient.height; y++) {
+        bool done = region_.for_each_fit(orient, y, [&](int x) {
+          uint64_t piece_hash = table_ ? keys_->shape(orient, x, y) : 0;
+          region_.place(orient, x, y);
+          board_hash_ ^= piece_hash;
+          if (solve(idx + 1))
+            return true;
+          region_.unplace(orient, x, y);
+          board_hash_ ^= piece_hash;
+          stats_.backtracks++;
+          return budget_.stopped();
+        });
+        if (done)
+          return !budget_.stopped();
+      }
     }
+
+    // Only a completed search proves the state cannot be packed
+    if (table_)
+      table_->refute(key);
+    return false;
   }
 };
 
+// Read-only piece catalog; safe to share across threads
 class Solver {
   std::vector<std::vector<Shape>> all_shapes;
   std::vector<int> shape_sizes;
-  bool timeout = false;
-  std::chrono::steady_clock::time_point start_time;
-  static constexpr int TIMEOUT_MS = 1000; // 1 second per region
+  std::vector<int> shape_imbalance; // Checkerboard color imbalance
+  bool all_fit_3x3 = true;          // Every shape's bounding box <= 3x3
+  Engine engine = Engine::Backtrack;
+  bool use_table = true;
+
+  // Transposition table size per region: 2^18 slots, 2 MiB
+  static constexpr int TABLE_LOG2_SLOTS = 18;
+
+  // Split hard regions until there are this many subtrees per worker, but
+  // never deeper than MAX_SPLIT_DEPTH pieces
+  static constexpr size_t SUBTREES_PER_WORKER = 8;
+  static constexpr size_t MAX_SPLIT_DEPTH = 3;
 
 public:
+  void set_engine(Engine e) { engine = e; }
+  void set_table(bool enabled) { use_table = enabled; }
+
+  // Whether can_fit_split actually spreads one region over the pool
+  bool splits_regions() const { return engine == Engine::Backtrack; }
+
   void add_shape(const Shape &s) {
     while (all_shapes.size() <= static_cast<size_t>(s.index)) {
       all_shapes.push_back({});
       shape_sizes.push_back(0);
+      shape_imbalance.push_back(0);
     }
     all_shapes[s.index] = s.all_orientations();
     shape_sizes[s.index] = s.cell_count();
+    shape_imbalance[s.index] = s.color_imbalance();
+    all_fit_3x3 = all_fit_3x3 && s.width <= 3 && s.height <= 3;
   }
 
-  bool can_fit(Region &region) {
-    // Quick check: total # cells must fit in grid
-    int total_cells = 0;
+  // Settle a region without searching if one of the cheap bounds applies:
+  //   Area:     the pieces have more cells than the region
+  //   Boxes:    every piece fits a 3x3 box and the region tiles enough
+  //             boxes for one piece each
+  //   Coloring: no choice of piece colorings matches the region's
+  //             checkerboard black/white cell counts
+  std::optional<FitResult> classify(const Region &region) const {
+    int total_cells = 0, total_pieces = 0, max_imbalance = 0;
     for (size_t i = 0; i < region.piece_counts.size() && i < shape_sizes.size();
          i++) {
       total_cells += region.piece_counts[i] * shape_sizes[i];
+      total_pieces += region.piece_counts[i];
+      max_imbalance += region.piece_counts[i] * shape_imbalance[i];
     }
-    if (total_cells > region.width * region.height) {
-      return false;
+    int area = region.width * region.height;
+    if (total_cells > area)
+      return FitResult{Verdict::NoFit, Tier::Area};
+
+    if (all_fit_3x3 &&
+        total_pieces <= (region.width / 3) * (region.height / 3))
+      return FitResult{Verdict::Fits, Tier::Boxes};
+
+    // Pieces cover (total + S) / 2 black cells, where S is the signed sum
+    // of piece imbalances. Only worth enumerating S when the free cells
+    // cannot absorb every possible imbalance.
+    int black = (area + 1) / 2, white = area / 2;
+    int lo = total_cells - 2 * white, hi = 2 * black - total_cells;
+    if (lo <= -max_imbalance && max_imbalance <= hi)
+      return std::nullopt;
+
+    std::vector<char> reach(2 * max_imbalance + 1, 0), next;
+    reach[max_imbalance] = 1; // Offset so index max_imbalance is S = 0
+    for (size_t i = 0; i < region.piece_counts.size() && i < shape_sizes.size();
+         i++) {
+      int d = shape_imbalance[i];
+      if (d == 0)
+        continue;
+      for (int c = 0; c < region.piece_counts[i]; c++) {
+        next.assign(reach.size(), 0);
+        for (size_t v = 0; v < reach.size(); v++) {
+          if (!reach[v])
+            continue;
+          if (v >= static_cast<size_t>(d))
+            next[v - d] = 1;
+          if (v + d < reach.size())
+            next[v + d] = 1;
+        }
+        reach.swap(next);
+      }
+    }
+    for (int v = std::max(lo, -max_imbalance);
+         v <= std::min(hi, max_imbalance); v++) {
+      if (reach[v + max_imbalance])
+        return std::nullopt;
     }
+    return FitResult{Verdict::NoFit, Tier::Coloring};
+  }
+
+  // Sequential search of one region
+  FitResult can_fit(Region &region, const SearchLimits &limits) const {
+    if (auto decided = classify(region))
+      return *decided;
+
+    if (engine == Engine::Dlx) {
+      DlxPacker packer(region, all_shapes, shape_sizes, limits);
+      Verdict verdict = packer.solve();
+      return {verdict, Tier::Search, packer.stats()};
+    }
+
+    auto pieces = piece_list(region);
+    if (pieces.empty())
+      return {Verdict::Fits};
 
+    region.clear();
+    BacktrackSearch search(all_shapes, pieces, region, limits);
+    std::optional<ZobristKeys> keys;
+    std::optional<TranspositionTable> table;
+    if (use_table) {
+      keys.emplace(region, pieces);
+      table.emplace(TABLE_LOG2_SLOTS);
+      search.use_table(*keys, *table);
+    }
+    Verdict verdict = search.run(0);
+    return {verdict, Tier::Search, search.stats()};
+  }
+
+  // One region, with the first few branching levels expanded into
+  // independent subtrees searched in parallel on the pool. The first
+  // subtree to find a packing cancels the rest. Each subtree gets an equal
+  // share of the node budget. Backtracking engine only; DLX regions are
+  // searched sequentially.
+  FitResult can_fit_split(Region &region, aoc::ThreadPool &pool,
+                          const SearchLimits &limits) const {
+    if (engine != Engine::Backtrack || classify(region))
+      return can_fit(region, limits);
+
+    auto pieces = piece_list(region);
+    if (pieces.empty())
+      return {Verdict::Fits};
+    region.clear();
+
+    struct Placement {
+      const Shape *orient;
+      int x, y;
+    };
+    auto apply = [](Region &r, const std::vector<Placement> &path) {
+      for (const auto &p : path)
+        r.place(*p.orient, p.x, p.y);
+    };
+
+    // Breadth-first expansion of the top levels
+    std::vector<std::vector<Placement>> roots = {{}};
+    size_t depth = 0;
+    while (depth < pieces.size() && depth < MAX_SPLIT_DEPTH &&
+           roots.size() < pool.size() * SUBTREES_PER_WORKER) {
+      int shape_idx = pieces[depth];
+      if (shape_idx >= static_cast<int>(all_shapes.size()))
+        return {};
+      std::vector<std::vector<Placement>> next;
+      for (const auto &path : roots) {
+        Region scratch = region;
+        apply(scratch, path);
+        for (const auto &orient : all_shapes[shape_idx]) {
+          for (int y = 0; y <= scratch.height - orient.height; y++) {
+            scratch.for_each_fit(orient, y, [&](int x) {
+              next.push_back(path);
+              next.back().push_back({&orient, x, y});
+              return false;
+            });
+          }
+        }
+      }
+      roots = std::move(next);
+      depth++;
+    }
+    if (roots.empty())
+      return {};
+    if (depth == pieces.size())
+      return {Verdict::Fits};
+
+    std::optional<ZobristKeys> keys;
+    std::optional<TranspositionTable> table;
+    if (use_table) {
+      keys.emplace(region, pieces);
+      table.emplace(TABLE_LOG2_SLOTS);
+    }
+    std::atomic<bool> found{false}, unknown{false};
+    SearchLimits subtree_limits = limits;
+    subtree_limits.cancel = &found;
+    if (limits.node_budget)
+      subtree_limits.node_budget =
+          std::max<uint64_t>(1, limits.node_budget / roots.size());
+
+    std::vector<SearchStats> subtree_stats(roots.size());
+    for (size_t r = 0; r < roots.size(); r++) {
+      pool.submit([&, r, depth](unsigned) {
+        if (found.load(std::memory_order_relaxed))
+          return;
+        aoc::TraceScope span("subtree", "index", r);
+        Region local = region;
+        apply(local, roots[r]);
+        BacktrackSearch search(all_shapes, pieces, local, subtree_limits);
+        if (table)
+          search.use_table(*keys, *table);
+        Verdict verdict = search.run(depth);
+        subtree_stats[r] = search.stats();
+        if (verdict == Verdict::Fits)
+          found = true;
+        else if (verdict == Verdict::Unknown)
+          unknown = true;
+      });
+    }
+    pool.wait();
+
+    SearchStats stats;
+    for (const auto &st : subtree_stats)
+      stats += st;
+    Verdict verdict = found       ? Verdict::Fits
+                      : unknown   ? Verdict::Unknown
+                                  : Verdict::NoFit;
+    return {verdict, Tier::Search, stats};
+  }
+
+private:
+  // Every piece copy, largest first
+  std::vector<int> piece_list(const Region &region) const {
     std::vector<std::pair<int, int>> pieces;
     for (size_t i = 0; i < region.piece_counts.size(); i++) {
       if (i >= shape_sizes.size())
@@ -144,57 +869,53 @@ public:
     std::vector<int> piece_list;
     for (auto &[idx, sz] : pieces)
       piece_list.push_back(idx);
-
-    if (piece_list.empty())
-      return true;
-
-    region.grid.assign(region.height, std::vector<bool>(region.width, false));
-
-    timeout = false;
-    start_time = std::chrono::steady_clock::now();
-    return solve(region, piece_list, 0);
+    return piece_list;
   }
+};
 
-private:
-  bool check_timeout() {
-    auto now = std::chrono::steady_clock::now();
-    auto elapsed =
-        std::chrono::duration_cast<std::chrono::milliseconds>(now - start_time)
-            .count();
-    return elapsed > TIMEOUT_MS;
-  }
+// Regions run in parallel on the pool with a small probe budget each.
+// Regions still undecided after the probe are hard: they are then taken
+// one at a time with the whole pool splitting their search tree.
+constexpr uint64_t PROBE_NODES = 100'000;
 
-  bool solve(Region &region, const std::vector<int> &pieces, size_t idx) {
-    if (idx >= pieces.size())
-      return true;
+// Default per-region budget for the full search (--nodes=0: unlimited)
+constexpr uint64_t DEFAULT_NODE_BUDGET = 50'000'000;
 
-    // Check timeout periodically
-    if ((idx % 3 == 0) && check_timeout()) {
-      timeout = true;
-      return false;
-    }
+std::vector<FitResult> solve_regions(const Solver &solver,
+                                     std::vector<Region> &regions,
+                                     aoc::ThreadPool &pool,
+                                     const SearchLimits &limits) {
+  SearchLimits probe = limits;
+  if (!probe.node_budget || probe.node_budget > PROBE_NODES)
+    probe.node_budget = PROBE_NODES;
 
-    int shape_idx = pieces[idx];
-    if (shape_idx >= static_cast<int>(all_shapes.size()))
-      return false;
+  std::vector<FitResult> results(regions.size());
+  for (size_t r = 0; r < regions.size(); r++) {
+    pool.submit([&, r](unsigned) {
+      aoc::TraceScope span("region probe", "region", r);
+      results[r] = solver.can_fit(regions[r], probe);
+    });
+  }
+  pool.wait();
+  if (probe.node_budget == limits.node_budget)
+    return results;
 
-    for (const auto &orient : all_shapes[shape_idx]) {
-      for (int y = 0; y <= region.height - orient.height; y++) {
-        for (int x = 0; x <= region.width - orient.width; x++) {
-          if (region.can_place(orient, x, y)) {
-            region.place(orient, x, y);
-            if (solve(region, pieces, idx + 1))
-              return true;
-            region.unplace(orient, x, y);
-            if (timeout)
-              return false;
-          }
-        }
-      }
+  for (size_t r = 0; r < regions.size(); r++) {
+    if (results[r].verdict != Verdict::Unknown)
+      continue;
+    if (solver.splits_regions()) {
+      aoc::TraceScope span("region search", "region", r);
+      results[r] = solver.can_fit_split(regions[r], pool, limits);
+    } else {
+      pool.submit([&, r](unsigned) {
+        aoc::TraceScope span("region search", "region", r);
+        results[r] = solver.can_fit(regions[r], limits);
+      });
     }
-    return false;
   }
-};
+  pool.wait();
+  return results;
+}
 
 std::string trim(const std::string &s) {
   size_t start = s.find_first_not_of(" \t\r\n");
@@ -206,6 +927,7 @@ std::string trim(const std::string &s) {
 
 std::pair<std::vector<Shape>, std::vector<Region>>
 parse_input(const std::vector<std::string> &lines) {
+  aoc::TraceScope span("parse");
   std::vector<Shape> shapes;
   std::vector<Region> regions;
 
@@ -292,31 +1014,125 @@ parse_input(const std::vector<std::string> &lines) {
 
 int main(int argc, char *argv[]) {
   if (argc < 2) {
-    std::cerr << "Usage: " << argv[0] << " <input_file>\n";
+    std::cerr << "Usage: " << argv[0]
+              << " <input_file> [--engine=backtrack|dlx] [--nodes=N]"
+                 " [--time-limit-ms=N] [--stats] [--cache[=mode]]"
+                 " [--trace=file]\n";
     return 1;
   }
 
+  aoc::ResultCache cache(12);
+  Engine engine = Engine::Backtrack;
+  bool use_table = true, region_stats = false;
+  uint64_t node_budget = DEFAULT_NODE_BUDGET, time_limit_ms = 0;
+  for (int i = 2; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--engine=dlx")
+      engine = Engine::Dlx;
+    else if (arg == "--table=off")
+      use_table = false;
+    else if (arg == "--stats")
+      region_stats = true;
+    else if (arg.rfind("--nodes=", 0) == 0)
+      node_budget = std::stoull(arg.substr(8));
+    else if (arg.rfind("--time-limit-ms=", 0) == 0)
+      time_limit_ms = std::stoull(arg.substr(16));
+    else if (arg != "--engine=backtrack" && arg != "--table=on" &&
+             !cache.parse_option(arg) && !aoc::parse_trace_option(arg)) {
+      std::cerr << "Unknown option: " << arg << "\n";
+      return 1;
+    }
+  }
+
+  auto make_solver = [&](const std::vector<Shape> &shapes) {
+    Solver solver;
+    solver.set_engine(engine);
+    solver.set_table(use_table);
+    for (const auto &shape : shapes) {
+      solver.add_shape(shape);
+    }
+    return solver;
+  };
+  // The time limit applies per input, starting when its search does
+  auto make_limits = [&] {
+    SearchLimits limits;
+    limits.node_budget = node_budget;
+    if (time_limit_ms > 0)
+      limits.deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(time_limit_ms);
+    return limits;
+  };
+
+  if (auto batch = aoc::batch_inputs(argv[1])) {
+    struct BatchState {
+      std::vector<std::string> lines;
+      aoc::ThreadPool pool;
+    };
+    return aoc::run_batch<BatchState>(
+        *batch, [&](BatchState &s, const std::string &text) {
+          aoc::split_lines(text, s.lines);
+          auto [shapes, regions] = parse_input(s.lines);
+          Solver solver = make_solver(shapes);
+          auto results = solve_regions(solver, regions, s.pool, make_limits());
+          auto fits = std::count_if(
+              results.begin(), results.end(),
+              [](const FitResult &r) { return r.verdict == Verdict::Fits; });
+          return std::vector<std::string>{std::to_string(fits)};
+        });
+  }
+
+  cache.open(argv[1]);
+
   auto lines = aoc::read_lines(argv[1]);
   auto [shapes, regions] = parse_input(lines);
 
   std::cerr << "Parsed " << shapes.size() << " shapes and " << regions.size()
             << " regions\n";
 
-  Solver solver;
-  for (const auto &shape : shapes) {
-    solver.add_shape(shape);
-  }
+  Solver solver = make_solver(shapes);
 
-  int64_t count = 0;
-  {
-    aoc::Timer t("Part 1");
-    for (size_t r = 0; r < regions.size(); r++) {
-      if (solver.can_fit(regions[r])) {
+  cache.part(1, [&] {
+    aoc::ThreadPool pool;
+    auto results = solve_regions(solver, regions, pool, make_limits());
+
+    int64_t count = 0, by_tier[4] = {}, unknown = 0;
+    SearchStats stats;
+    for (size_t r = 0; r < results.size(); r++) {
+      const auto &result = results[r];
+      if (result.verdict == Verdict::Fits) {
         count++;
+      } else if (result.verdict == Verdict::Unknown) {
+        unknown++;
+      }
+      by_tier[static_cast<int>(result.tier)]++;
+      stats += result.stats;
+
+      if (region_stats && result.tier == Tier::Search) {
+        static const char *verdicts[] = {"fits", "no fit", "unknown"};
+        std::cerr << "Region " << r << " (" << regions[r].width << "x"
+                  << regions[r].height
+                  << "): " << verdicts[static_cast<int>(result.verdict)]
+                  << ", nodes " << result.stats.nodes << ", backtracks "
+                  << result.stats.backtracks << ", max depth "
+                  << result.stats.max_depth << "\n";
       }
     }
-    std::cout << "Part 1: " << count << "\n";
-  }
+    std::cerr << "Decided by area: " << by_tier[0]
+              << ", boxes: " << by_tier[1] << ", coloring: " << by_tier[2]
+              << ", search: " << by_tier[3] << "\n";
+    if (by_tier[3] > 0) {
+      std::cerr << "Search nodes: " << stats.nodes
+                << ", backtracks: " << stats.backtracks
+                << ", table hits: " << stats.table_hits
+                << ", misses: " << stats.table_misses << "\n";
+    }
+    if (unknown > 0) {
+      std::cerr << "Warning: " << unknown
+                << " regions undecided within the search budget; counted as "
+                   "not fitting\n";
+    }
+    return count;
+  });
 
   return 0;
 }
@@ -162,6 +162,7 @@ class TestDay08:
 425,690,689
 """
     EXPECTED_PART1 = 40  # After 10 connections: 5*4*2
+    EXPECTED_PART2 = 25272
 
     def test_part1_example(self):
         # This example uses 10 connections, our solution uses 1000
@@ -169,6 +170,11 @@ class TestDay08:
         output = run_solution(8, self.EXAMPLE_INPUT)
         assert "Part 1:" in output or "SKIP" in output
 
+    def test_part2_example(self):
+        # Last connection joins 216,146,977 and 117,168,530: 216 * 117
+        output = run_solution(8, self.EXAMPLE_INPUT)
+        assert "25272" in output or "SKIP" in output
+
 
 class TestDay09:
     """Day 9: Movie Theater - Largest Rectangle"""
@@ -183,11 +189,17 @@ class TestDay09:
 7,3
 """
     EXPECTED_PART1 = 50  # Rectangle between (2,5) and (11,1)
+    EXPECTED_PART2 = 24
 
     def test_part1_example(self):
         output = run_solution(9, self.EXAMPLE_INPUT)
         assert "50" in output or "SKIP" in output
 
+    def test_part2_example(self):
+        # Largest all-red/green rectangle: (9,5) to (2,3)
+        output = run_solution(9, self.EXAMPLE_INPUT)
+        assert "Part 2: 24" in output or "SKIP" in output
+
 
 class TestDay10:
     """Day 10: Factory - Indicator Light Configuration"""
@@ -197,11 +209,17 @@ class TestDay10:
 [.###.#] (0,1,2,3,4) (0,3,4) (0,1,2,4,5) (1,2) {10,11,11,5,10,5}
 """
     EXPECTED_PART1 = 7  # 2 + 3 + 2
+    EXPECTED_PART2 = 33  # 10 + 12 + 11
 
     def test_part1_example(self):
         output = run_solution(10, self.EXAMPLE_INPUT)
         assert "7" in output or "SKIP" in output
 
+    def test_part2_example(self):
+        # Joltage counters: 10 + 12 + 11 presses
+        output = run_solution(10, self.EXAMPLE_INPUT)
+        assert "Part 2: 33" in output or "SKIP" in output
+
 
 class TestDay11:
     """Day 11: Reactor - Path Counting"""
@@ -223,6 +241,26 @@ iii: out
         output = run_solution(11, self.EXAMPLE_INPUT)
         assert "5" in output or "SKIP" in output
 
+    EXAMPLE_INPUT_PART2 = """svr: aaa bbb
+aaa: fft
+fft: ccc
+bbb: tty
+tty: ccc
+ccc: ddd eee
+ddd: hub
+hub: fff
+eee: dac
+dac: fff
+fff: ggg hhh
+ggg: out
+hhh: out
+"""
+    EXPECTED_PART2 = 2  # svr->aaa->fft->ccc->eee->dac->fff->{ggg,hhh}->out
+
+    def test_part2_example(self):
+        output = run_solution(11, self.EXAMPLE_INPUT_PART2)
+        assert "Part 2: 2" in output or "SKIP" in output
+
 
 class TestDay12:
     """Day 12: Christmas Tree Farm - Present Packing"""